@@ -0,0 +1,123 @@
+// 短连接建连速率：每个客户端线程不停地 connect -> 发1字节 -> 等回显和服务端关闭 -> close，
+// 对比几种accept方式每秒能建立多少连接，以及服务端每秒完成多少次连接的建立+销毁
+//   single-1: mainLoop上一个Acceptor，每个可读事件只accept一个连接
+//   single:   mainLoop上一个Acceptor，每个可读事件最多accept 16个，accept之后轮询转交给subloop（默认）
+//   per-loop: 每个subloop一个SO_REUSEPORT的Acceptor，在本线程accept并建立连接
+//
+// 用法: ./accept_bench [IO线程数] [客户端线程数] [每种方式的秒数]
+
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/Logger.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+
+// 完成一次短连接，成功返回true
+static bool shortConnection(const sockaddr_in& addr) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(fd, (const sockaddr*)&addr, sizeof addr) < 0) {
+        ::close(fd);
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    // 服务端先关闭，TIME_WAIT留在服务端，客户端的本地端口不会被用光
+    char c = 'x';
+    bool ok = ::write(fd, &c, 1) == 1 && ::read(fd, &c, 1) == 1 &&
+              ::read(fd, &c, 1) == 0;
+    ::close(fd);
+    return ok;
+}
+
+static void bench(const char* name, TcpServer::Option option,
+                  int maxAccepts, uint16_t port, int ioThreads, int clients,
+                  int seconds) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    TcpServer* server = nullptr;
+    std::atomic<long> closed(0);  // 服务端建立并销毁完的连接
+    loop->runInLoop([&] {
+        server = new TcpServer(loop, InetAddress(port), "bench", option);
+        server->setThreadNum(ioThreads);
+        server->setMaxAcceptsPerEvent(maxAccepts);
+        server->setConnectionCallback([&closed](const TcpConnectionPtr& conn) {
+            if (!conn->connected()) {
+                ++closed;
+            }
+        });
+        server->setMessageCallback(
+            [](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+                conn->send(buf);
+                conn->shutdown();
+            });
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    std::atomic_bool stop(false);
+    std::atomic<long> done(0);
+    std::atomic<long> failed(0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&] {
+            while (!stop) {
+                if (shortConnection(addr)) {
+                    ++done;
+                } else {
+                    ++failed;
+                }
+            }
+        });
+    }
+    ::sleep(seconds);
+    stop = true;
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    printf("%-9s %8.0f conn/s  %8.0f server setup+teardown/s  (%ld connections, "
+           "%ld failed; server accepted %ld, dropped %ld, errors %ld)\n",
+           name, done / elapsed, closed / elapsed, static_cast<long>(done),
+           static_cast<long>(failed), static_cast<long>(server->numAccepted()),
+           static_cast<long>(server->numAcceptDropped()),
+           static_cast<long>(server->numAcceptErrors()));
+
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+}
+
+int main(int argc, char* argv[]) {
+    int ioThreads = argc > 1 ? atoi(argv[1]) : 4;
+    int clients = argc > 2 ? atoi(argv[2]) : 8;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    uint16_t port = 9981;
+
+    // 每个连接都有几行INFO日志，会把差别淹没掉
+    Logger::setMinLogLevel(ERROR);
+
+    bench("single-1", TcpServer::kNoReusePort, 1, port++, ioThreads, clients,
+          seconds);
+    bench("single", TcpServer::kNoReusePort, 16, port++, ioThreads, clients,
+          seconds);
+    bench("per-loop", TcpServer::kReusePortPerLoop, 16, port++, ioThreads,
+          clients, seconds);
+    return 0;
+}
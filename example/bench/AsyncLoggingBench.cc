@@ -0,0 +1,109 @@
+// 日志吞吐测试：N个生产者线程同时调用LOG_INFO，对比几种输出方式
+//   null   只格式化，不输出（前端本身的开销）
+//   sync   每条日志加锁直接写LogFile（同步写文件）
+//   async  AsyncLogging 双缓冲，后台线程写文件
+// 同时给出生产者全部写完的时间，以及包括落盘在内的总时间
+//
+// 用法: ./async_logging_bench [null|sync|async] [生产者线程数] [每个线程的日志条数] [日志文件前缀]
+
+#include <mynetlib/AsyncLogging.h>
+#include <mynetlib/LogFile.h>
+#include <mynetlib/Logger.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+using Clock = std::chrono::steady_clock;
+
+static AsyncLogging* g_asyncLog = nullptr;
+static LogFile* g_logFile = nullptr;
+static std::mutex g_logFileMutex;
+static std::atomic<int64_t> g_bytes(0);
+
+static void nullOutput(const char* /*msg*/, int len) {
+    g_bytes.fetch_add(len, std::memory_order_relaxed);
+}
+
+static void syncOutput(const char* msg, int len) {
+    g_bytes.fetch_add(len, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(g_logFileMutex);
+    g_logFile->append(msg, len);
+}
+
+static void asyncOutput(const char* msg, int len) {
+    g_bytes.fetch_add(len, std::memory_order_relaxed);
+    g_asyncLog->append(msg, len);
+}
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "async";
+    int numThreads = argc > 2 ? atoi(argv[2]) : 4;
+    int perThread = argc > 3 ? atoi(argv[3]) : 200000;
+    std::string basename = argc > 4 ? argv[4] : "/tmp/async_logging_bench";
+    const off_t kRollSize = 500 * 1000 * 1000;
+
+    if (mode == "null") {
+        Logger::setOutput(nullOutput);
+    } else if (mode == "sync") {
+        g_logFile = new LogFile(basename, kRollSize);
+        Logger::setOutput(syncOutput);
+    } else if (mode == "async") {
+        g_asyncLog = new AsyncLogging(basename, kRollSize);
+        g_asyncLog->start();
+        Logger::setOutput(asyncOutput);
+    } else {
+        fprintf(stderr, "usage: %s [null|sync|async] [threads] [messages] [basename]\n",
+                argv[0]);
+        return 1;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> producers;
+    for (int t = 0; t < numThreads; ++t) {
+        producers.emplace_back([t, perThread] {
+            for (int i = 0; i < perThread; ++i) {
+                LOG_INFO("Hello 0123456789 abcdefghijklmnopqrstuvwxyz thread=%d seq=%d",
+                         t, i);
+            }
+        });
+    }
+    for (auto& th : producers) {
+        th.join();
+    }
+    double frontSeconds = secondsSince(start);
+
+    if (g_asyncLog) {
+        g_asyncLog->stop();
+    }
+    if (g_logFile) {
+        g_logFile->flush();
+    }
+    double totalSeconds = secondsSince(start);
+
+    double total = static_cast<double>(numThreads) * perThread;
+    printf("%-5s threads=%d messages=%.0f: front-end %.3fs %.0f msg/s, "
+           "total %.3fs %.0f msg/s, %.1f MB/s\n",
+           mode.c_str(), numThreads, total, frontSeconds, total / frontSeconds,
+           totalSeconds, total / totalSeconds,
+           g_bytes.load() / totalSeconds / 1024 / 1024);
+    if (g_asyncLog) {
+        printf("dropped buffers: %lld\n",
+               static_cast<long long>(g_asyncLog->droppedBuffers()));
+    }
+
+    delete g_asyncLog;
+    delete g_logFile;
+    return 0;
+}
@@ -0,0 +1,112 @@
+// 测量一次 readFd 的开销（不同的包大小）
+//   legacy: 以前的做法，每次读都在栈上开一个清零的64K extrabuf
+//   buffer: 现在的 Buffer::readFd（线程局部的extrabuf，不清零）
+//   chain:  ChainBuffer::readFd（直接读进池化的块）
+// 每轮先往socketpair的一端写一个包，再从另一端读出来，读完就丢
+// 写的开销各个模式都一样，看差值即可
+//
+// 用法: ./buffer_read_bench [每种大小的轮数]
+
+#include <mynetlib/Buffer.h>
+#include <mynetlib/ChainBuffer.h>
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace mynetlib;
+
+// 原来的 Buffer::readFd 的开销：栈上清零的64K + readv + 拷贝
+static ssize_t legacyReadFd(Buffer* buf, int fd, int* saveErrno) {
+    char extrabuf[65536] = {0};
+    struct iovec vec[1];
+    vec[0].iov_base = extrabuf;
+    vec[0].iov_len = sizeof extrabuf;
+    // 防止编译器把清零优化掉
+    asm volatile("" : : "r"(extrabuf) : "memory");
+    const ssize_t n = ::readv(fd, vec, 1);
+    if (n < 0) {
+        *saveErrno = errno;
+    } else {
+        buf->append(extrabuf, n);
+    }
+    return n;
+}
+
+template <typename ReadFunc>
+static double bench(int fds[2], const std::string& payload, int rounds,
+                    ReadFunc&& read) {
+    int savedErrno = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        size_t left = payload.size();
+        if (::write(fds[0], payload.data(), left) != static_cast<ssize_t>(left)) {
+            perror("write");
+            exit(1);
+        }
+        while (left > 0) {
+            ssize_t n = read(fds[1], &savedErrno);
+            if (n <= 0) {
+                perror("read");
+                exit(1);
+            }
+            left -= n;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           rounds;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200000;
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+    int sndbuf = 1024 * 1024;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof sndbuf);
+
+    printf("%8s %12s %12s %12s  (ns/round)\n", "size", "legacy", "buffer",
+           "chain");
+    const size_t sizes[] = {16, 256, 4096, 65536};
+    for (size_t size : sizes) {
+        const std::string payload(size, 'x');
+        int n = size >= 65536 ? rounds / 10 : rounds;
+
+        Buffer legacy;
+        double legacyNs = bench(fds, payload, n, [&](int fd, int* err) {
+            ssize_t r = legacyReadFd(&legacy, fd, err);
+            legacy.retrieveAll();
+            return r;
+        });
+
+        Buffer buffer;
+        double bufferNs = bench(fds, payload, n, [&](int fd, int* err) {
+            ssize_t r = buffer.readFd(fd, err);
+            buffer.retrieveAll();
+            return r;
+        });
+
+        ChainBuffer chain;
+        double chainNs = bench(fds, payload, n, [&](int fd, int* err) {
+            ssize_t r = chain.readFd(fd, err);
+            chain.retrieveAll();
+            return r;
+        });
+
+        printf("%8zu %12.1f %12.1f %12.1f\n", size, legacyNs, bufferNs,
+               chainNs);
+    }
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// 工作线程生成响应，交给IO线程发送的吞吐量
+//   copy:   send(const std::string&)，跨线程时拷贝一份
+//   move:   send(std::string&&)，string移动进回调
+//   buffer: send(Buffer*)，和空Buffer交换
+//   shared: send(PayloadPtr)，同一份不可变数据只增加引用计数
+// copy/move/buffer 每条消息都由工作线程新生成一份（和真实的响应一样），shared 复用同一份
+// 客户端读了就丢，统计从开始发送到客户端收完的时间
+//
+// 用法: ./cross_thread_send_bench [消息大小KB] [消息条数]
+
+#include <mynetlib/Buffer.h>
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+
+enum Mode { kCopy, kMove, kBuffer, kShared };
+
+static const char* modeName(Mode mode) {
+    switch (mode) {
+        case kCopy: return "copy";
+        case kMove: return "move";
+        case kBuffer: return "buffer";
+        case kShared: return "shared";
+    }
+    return "";
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    if (::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+static void bench(Mode mode, uint16_t port, size_t msgSize, int count) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    std::promise<TcpConnectionPtr> connected;
+
+    TcpServer* server = nullptr;
+    loop->runInLoop([&] {
+        server = new TcpServer(loop, InetAddress(port), "bench");
+        server->setConnectionCallback([&](const TcpConnectionPtr& conn) {
+            if (conn->connected()) {
+                connected.set_value(conn);
+            }
+        });
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    const size_t total = msgSize * count;
+    int fd = connectTo(port);
+    TcpConnectionPtr conn = connected.get_future().get();
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread client([fd, total] {
+        std::vector<char> buf(1024 * 1024);
+        size_t received = 0;
+        while (received < total) {
+            ssize_t n = ::read(fd, buf.data(), buf.size());
+            if (n <= 0) break;
+            received += n;
+        }
+    });
+
+    const std::string content(msgSize, 'x');
+    const PayloadPtr shared = std::make_shared<const std::string>(content);
+    for (int i = 0; i < count; ++i) {
+        switch (mode) {
+            case kCopy: {
+                std::string message(content);
+                conn->send(message);
+                break;
+            }
+            case kMove: {
+                std::string message(content);
+                conn->send(std::move(message));
+                break;
+            }
+            case kBuffer: {
+                Buffer message;
+                message.append(content.data(), content.size());
+                conn->send(&message);
+                break;
+            }
+            case kShared:
+                conn->send(shared);
+                break;
+        }
+    }
+    client.join();
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double mb = static_cast<double>(total) / (1024 * 1024);
+    printf("%-7s %6zu KB x %6d  %7.3f s  %8.1f MB/s  %9.0f msg/s\n",
+           modeName(mode), msgSize / 1024, count, seconds, mb / seconds,
+           count / seconds);
+
+    ::close(fd);
+    conn.reset();
+    ::usleep(100 * 1000);
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+}
+
+int main(int argc, char* argv[]) {
+    size_t msgSize = (argc > 1 ? atoi(argv[1]) : 16) * 1024;
+    int count = argc > 2 ? atoi(argv[2]) : 20000;
+    uint16_t port = 9991;
+
+    const Mode modes[] = {kCopy, kMove, kBuffer, kShared};
+    for (Mode mode : modes) {
+        bench(mode, port++, msgSize, count);
+    }
+    return 0;
+}
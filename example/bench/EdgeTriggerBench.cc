@@ -0,0 +1,130 @@
+// 对比水平触发(LT)和边沿触发(ET)下大块数据传输的表现
+//   upload:   客户端不停地写，服务端读了就丢
+//   download: 服务端用writeCompleteCallback不停地发，客户端读了就丢
+// 输出传输速度以及服务端loop的循环次数（即epoll_wait返回的次数）
+// 系统调用次数可以用 strace -c -f ./edge_trigger_bench 查看
+//
+// 用法: ./edge_trigger_bench [连接数] [每个连接传输的MB数]
+
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+
+static const size_t kChunk = 1024 * 1024;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    if (::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+static void bench(bool edgeTriggered, bool upload, uint16_t port, int conns,
+                  size_t bytesPerConn) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    const std::string payload(kChunk, 'x');
+    std::atomic_long pending(conns);
+
+    TcpServer* server = nullptr;
+    loop->runInLoop([&] {
+        server = new TcpServer(loop, InetAddress(port), "bench");
+        server->setEdgeTriggered(edgeTriggered);
+        server->setConnectionCallback([&](const TcpConnectionPtr& conn) {
+            if (conn->connected() && !upload) {
+                conn->setContext(bytesPerConn);
+                conn->send(payload);
+            }
+        });
+        server->setMessageCallback(
+            [](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+                buf->retrieveAll();
+            });
+        server->setWriteCompleteCallback([&](const TcpConnectionPtr& conn) {
+            size_t* left = std::any_cast<size_t>(conn->getMutableContext());
+            *left = *left > kChunk ? *left - kChunk : 0;
+            if (*left > 0) {
+                conn->send(payload);
+            } else {
+                conn->shutdown();
+            }
+        });
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    int64_t startIteration = 0;
+    loop->runInLoop([&] { startIteration = loop->iteration(); });
+    ::usleep(10 * 1000);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int i = 0; i < conns; ++i) {
+        clients.emplace_back([&] {
+            int fd = connectTo(port);
+            std::vector<char> buf(kChunk);
+            if (upload) {
+                size_t sent = 0;
+                while (sent < bytesPerConn) {
+                    ssize_t n = ::write(fd, payload.data(), payload.size());
+                    if (n <= 0) break;
+                    sent += n;
+                }
+                ::shutdown(fd, SHUT_WR);
+                while (::read(fd, buf.data(), buf.size()) > 0) {
+                }
+            } else {
+                while (::read(fd, buf.data(), buf.size()) > 0) {
+                }
+            }
+            ::close(fd);
+            --pending;
+        });
+    }
+    for (std::thread& t : clients) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    int64_t iterations = 0;
+    loop->runInLoop([&] { iterations = loop->iteration() - startIteration; });
+    ::usleep(10 * 1000);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double mb = static_cast<double>(bytesPerConn) * conns / (1024 * 1024);
+    printf("%s %-8s %8.1f MB  %7.3f s  %8.1f MB/s  loop iterations %8ld  (%.1f per MB)\n",
+           edgeTriggered ? "ET" : "LT", upload ? "upload" : "download", mb,
+           seconds, mb / seconds, static_cast<long>(iterations),
+           iterations / mb);
+
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+}
+
+int main(int argc, char* argv[]) {
+    int conns = argc > 1 ? atoi(argv[1]) : 4;
+    size_t mbPerConn = argc > 2 ? atoi(argv[2]) : 256;
+    uint16_t port = 9981;
+
+    for (int upload = 1; upload >= 0; --upload) {
+        bench(false, upload, port++, conns, mbPerConn * 1024 * 1024);
+        bench(true, upload, port++, conns, mbPerConn * 1024 * 1024);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+// 几个不停上传数据的连接（firehose）和一个做ping-pong的连接共用一个IO线程，
+// 对比不同读预算/时间预算下ping的往返延迟，以及loop每一轮的延迟直方图
+//   default: 默认行为（ET一直读到EAGAIN）
+//   budget:  每次读事件最多读64KB
+//   budget+time: 再加上每轮处理IO事件最多500us
+//
+// 用法: ./fairness_bench [firehose连接数] [ping次数]
+
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/LatencyHistogram.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    if (::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+static void bench(const char* name, size_t readBudget, int64_t timeBudgetUs,
+                  uint16_t port, int firehoses, int pings) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    TcpServer* server = nullptr;
+    loop->runInLoop([&] {
+        loop->enableLatencyStats(true);
+        loop->setEventTimeBudget(timeBudgetUs);
+        server = new TcpServer(loop, InetAddress(port), "bench");
+        server->setEdgeTriggered(true);
+        server->setReadBudget(readBudget, 0);
+        server->setConnectionCallback([](const TcpConnectionPtr&) {});
+        // 1字节的消息原样回显，大块数据直接丢掉
+        server->setMessageCallback(
+            [](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+                if (buf->readableBytes() == 1) {
+                    conn->send(buf);
+                } else {
+                    buf->retrieveAll();
+                }
+            });
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    std::atomic_bool stop(false);
+    std::vector<std::thread> senders;
+    for (int i = 0; i < firehoses; ++i) {
+        senders.emplace_back([&] {
+            int fd = connectTo(port);
+            std::string data(64 * 1024, 'x');
+            while (!stop) {
+                if (::write(fd, data.data(), data.size()) <= 0) break;
+            }
+            ::close(fd);
+        });
+    }
+    ::usleep(100 * 1000);
+
+    LatencyHistogram rtt;
+    int fd = connectTo(port);
+    for (int i = 0; i < pings; ++i) {
+        char c = 'p';
+        auto start = std::chrono::steady_clock::now();
+        if (::write(fd, &c, 1) != 1 || ::read(fd, &c, 1) != 1) {
+            perror("ping");
+            break;
+        }
+        auto end = std::chrono::steady_clock::now();
+        rtt.add(std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+                    .count());
+    }
+    ::close(fd);
+    stop = true;
+    for (std::thread& t : senders) {
+        t.join();
+    }
+
+    printf("%-12s ping rtt:        %s\n", name, rtt.toString().c_str());
+    printf("%-12s event handling:  %s\n", "", loop->eventHandlingLatency().toString().c_str());
+    printf("%-12s pending functors: %s  deferred events %ld\n", "",
+           loop->pendingFunctorsLatency().toString().c_str(),
+           static_cast<long>(loop->deferredEvents()));
+
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+}
+
+int main(int argc, char* argv[]) {
+    int firehoses = argc > 1 ? atoi(argv[1]) : 4;
+    int pings = argc > 2 ? atoi(argv[2]) : 2000;
+    uint16_t port = 9971;
+
+    bench("default", 0, 0, port++, firehoses, pings);
+    bench("budget", 64 * 1024, 0, port++, firehoses, pings);
+    bench("budget+time", 64 * 1024, 500, port++, firehoses, pings);
+    return 0;
+}
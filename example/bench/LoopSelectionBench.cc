@@ -0,0 +1,171 @@
+// 连接负载不均匀时，不同的loop选择策略对延迟的影响
+//
+// 先按 1个重连接 + 3个马上关闭的短连接 的顺序建立若干组连接：
+// 轮询时重连接全部落在同一个loop上，按连接数选择时能把它们分散开。
+// 重连接不停地上传数据，服务端对每块数据做一段计算；
+// 之后再建立一批ping连接，测它们的往返延迟，以及每个loop上的连接数。
+// 客户端从127.0.0.x的不同地址连接，按对端IP哈希时才有意义。
+// IO线程数不要超过空闲的CPU核数：核不够时所有loop抢同一批核，把重连接分散开反而让每个loop都变慢。
+//
+// 用法: ./loop_selection_bench [IO线程数] [重连接数] [ping连接数] [每个连接ping次数]
+
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/LatencyHistogram.h>
+#include <mynetlib/Logger.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+
+// 从127.0.0.(2 + source % 200)连接
+static int connectFrom(int source, uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(0x7f000002 + source % 200);
+    ::bind(fd, (sockaddr*)&local, sizeof local);
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    if (::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+// 模拟处理一块数据的计算
+static uint64_t burn(const char* data, size_t len) {
+    uint64_t h = 0;
+    for (int round = 0; round < 8; ++round) {
+        for (size_t i = 0; i < len; ++i) {
+            h = h * 31 + static_cast<unsigned char>(data[i]);
+        }
+    }
+    return h;
+}
+
+static void bench(const char* name, EventLoopThreadPool::LoopSelection selection,
+                  uint16_t port, int ioThreads, int heavies, int pingers,
+                  int pings) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    TcpServer* server = nullptr;
+    std::atomic<uint64_t> sink(0);
+    loop->runInLoop([&] {
+        server = new TcpServer(loop, InetAddress(port), "bench");
+        server->setThreadNum(ioThreads);
+        server->setLoopSelection(selection);
+        server->setConnectionCallback([](const TcpConnectionPtr&) {});
+        // 1字节的消息原样回显，其他的算一遍再丢掉
+        server->setMessageCallback(
+            [&sink](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+                if (buf->readableBytes() == 1) {
+                    conn->send(buf);
+                } else {
+                    sink += burn(buf->peek(), buf->readableBytes());
+                    buf->retrieveAll();
+                }
+            });
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    int source = 0;
+    std::vector<int> heavyFds;
+    for (int i = 0; i < heavies; ++i) {
+        heavyFds.push_back(connectFrom(source++, port));
+        for (int j = 0; j < 3; ++j) {
+            ::close(connectFrom(source++, port));
+        }
+        // 等服务端处理完短连接的关闭，连接数才是准的
+        ::usleep(20 * 1000);
+    }
+
+    std::atomic_bool stop(false);
+    std::vector<std::thread> senders;
+    for (int fd : heavyFds) {
+        senders.emplace_back([&stop, fd] {
+            std::string data(16 * 1024, 'x');
+            while (!stop) {
+                if (::write(fd, data.data(), data.size()) <= 0) break;
+            }
+            ::close(fd);
+        });
+    }
+
+    std::vector<int> pingFds;
+    for (int i = 0; i < pingers; ++i) {
+        pingFds.push_back(connectFrom(source++, port));
+    }
+    ::usleep(100 * 1000);
+
+    LatencyHistogram rtt;
+    for (int i = 0; i < pings; ++i) {
+        for (int fd : pingFds) {
+            char c = 'p';
+            auto start = std::chrono::steady_clock::now();
+            if (::write(fd, &c, 1) != 1 || ::read(fd, &c, 1) != 1) {
+                perror("ping");
+                exit(1);
+            }
+            auto end = std::chrono::steady_clock::now();
+            rtt.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                        end - start)
+                        .count());
+        }
+    }
+
+    std::string perLoop;
+    for (EventLoop* ioLoop : server->threadPool()->getAllLoops()) {
+        perLoop += " " + std::to_string(ioLoop->numConnections());
+    }
+    stop = true;
+    for (std::thread& t : senders) {
+        t.join();
+    }
+    for (int fd : pingFds) {
+        ::close(fd);
+    }
+
+    printf("%-14s conns per loop:%s\n", name, perLoop.c_str());
+    printf("%-14s ping rtt: %s\n", "", rtt.toString().c_str());
+
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+}
+
+int main(int argc, char* argv[]) {
+    int ioThreads = argc > 1 ? atoi(argv[1]) : 4;
+    int heavies = argc > 2 ? atoi(argv[2]) : 4;
+    int pingers = argc > 3 ? atoi(argv[3]) : 16;
+    int pings = argc > 4 ? atoi(argv[4]) : 200;
+    uint16_t port = 9991;
+
+    Logger::setMinLogLevel(ERROR);
+
+    bench("round-robin", EventLoopThreadPool::kRoundRobin, port++, ioThreads,
+          heavies, pingers, pings);
+    bench("least-conns", EventLoopThreadPool::kLeastConnections, port++,
+          ioThreads, heavies, pingers, pings);
+    bench("least-pending", EventLoopThreadPool::kLeastPendingFunctors, port++,
+          ioThreads, heavies, pingers, pings);
+    bench("hash-peer", EventLoopThreadPool::kHashPeerAddress, port++,
+          ioThreads, heavies, pingers, pings);
+    bench("power-of-two", EventLoopThreadPool::kPowerOfTwoChoices, port++,
+          ioThreads, heavies, pingers, pings);
+    return 0;
+}
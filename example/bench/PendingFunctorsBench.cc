@@ -0,0 +1,107 @@
+// 对比 EventLoop::pendingFunctors_ 的两种实现：
+//   1. 原来的 vector + mutex + swap
+//   2. 无锁的 MpscQueue
+// 多个生产者线程不停地投递回调，一个消费者线程模拟 doPendingFunctors 批量执行
+//
+// 用法: ./pending_functors_bench [生产者线程数] [每个线程投递的回调数]
+
+#include <mynetlib/MpscQueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+using Functor = std::function<void()>;
+
+// 原来 EventLoop 的做法
+class MutexQueue {
+public:
+    void push(Functor cb) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        pendingFunctors_.emplace_back(std::move(cb));
+    }
+
+    size_t consume() {
+        std::vector<Functor> functors;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            functors.swap(pendingFunctors_);
+        }
+        for (const Functor& functor : functors) {
+            functor();
+        }
+        return functors.size();
+    }
+
+private:
+    std::vector<Functor> pendingFunctors_;
+    std::mutex mutex_;
+};
+
+class LockFreeQueue {
+public:
+    void push(Functor cb) { queue_.push(std::move(cb)); }
+
+    size_t consume() {
+        return queue_.consume([](Functor& functor) { functor(); });
+    }
+
+private:
+    MpscQueue<Functor> queue_;
+};
+
+template <typename Queue>
+double run(int producers, int perProducer) {
+    Queue queue;
+    std::atomic_long executed(0);
+    const long total = static_cast<long>(producers) * perProducer;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        threads.emplace_back([&queue, &executed, perProducer] {
+            for (int j = 0; j < perProducer; ++j) {
+                queue.push([&executed] {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        });
+    }
+
+    // 消费者，相当于loop线程
+    long consumed = 0;
+    while (consumed < total) {
+        consumed += queue.consume();
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if (executed != total) {
+        printf("error: executed %ld of %ld\n", executed.load(), total);
+    }
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int producers = argc > 1 ? atoi(argv[1]) : 8;
+    int perProducer = argc > 2 ? atoi(argv[2]) : 1000000;
+    double total = static_cast<double>(producers) * perProducer;
+
+    printf("producers=%d functors/producer=%d\n", producers, perProducer);
+
+    double t1 = run<MutexQueue>(producers, perProducer);
+    printf("vector+mutex+swap : %8.3f s  %12.0f functors/s\n", t1, total / t1);
+
+    double t2 = run<LockFreeQueue>(producers, perProducer);
+    printf("MpscQueue         : %8.3f s  %12.0f functors/s\n", t2, total / t2);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+// 在同一个程序里对比不同的Poller实现
+// N 对 socketpair 首尾相连组成一个环，放入若干个令牌（1字节），
+// 每个channel读到令牌就写给下一对socket，统计一秒能传递多少次
+//
+// 用法: ./poller_bench [socketpair对数] [令牌数] [总传递次数]
+
+#include <mynetlib/Channel.h>
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/Timestamp.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace mynetlib;
+
+struct Ring {
+    EventLoop* loop;
+    std::vector<int> writeFds;
+    std::vector<int> readFds;
+    std::vector<std::unique_ptr<Channel>> channels;
+    long hops;
+    long target;
+};
+
+static void onRead(Ring* ring, int i) {
+    char c;
+    if (::read(ring->readFds[i], &c, 1) != 1) {
+        return;
+    }
+    ++ring->hops;
+    if (ring->hops >= ring->target) {
+        ring->loop->quit();
+        return;
+    }
+    int next = (i + 1) % ring->readFds.size();
+    ::write(ring->writeFds[next], &c, 1);
+}
+
+static double run(const char* name, Poller::Type type, int pairs, int tokens,
+                  long target) {
+    EventLoop loop(type);
+    Ring ring;
+    ring.loop = &loop;
+    ring.hops = 0;
+    ring.target = target;
+
+    for (int i = 0; i < pairs; ++i) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) < 0) {
+            perror("socketpair");
+            exit(1);
+        }
+        ring.writeFds.push_back(fds[0]);
+        ring.readFds.push_back(fds[1]);
+    }
+    for (int i = 0; i < pairs; ++i) {
+        ring.channels.emplace_back(new Channel(&loop, ring.readFds[i]));
+        ring.channels.back()->setReadCallback(
+            [&ring, i](Timestamp) { onRead(&ring, i); });
+        ring.channels.back()->enableReading();
+    }
+    for (int i = 0; i < tokens; ++i) {
+        char c = 't';
+        ::write(ring.writeFds[(i * pairs / tokens) % pairs], &c, 1);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    loop.loop();
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    printf("%-10s pairs=%d tokens=%d hops=%ld  %8.3f s  %10.0f hops/s\n", name,
+           pairs, tokens, ring.hops, seconds, ring.hops / seconds);
+
+    for (auto& channel : ring.channels) {
+        channel->disableAll();
+        channel->remove();
+    }
+    for (int i = 0; i < pairs; ++i) {
+        ::close(ring.writeFds[i]);
+        ::close(ring.readFds[i]);
+    }
+    return seconds;
+}
+
+int main(int argc, char* argv[]) {
+    int pairs = argc > 1 ? atoi(argv[1]) : 1000;
+    int tokens = argc > 2 ? atoi(argv[2]) : 100;
+    long target = argc > 3 ? atol(argv[3]) : 1000000;
+
+    run("epoll", Poller::kEPoll, pairs, tokens, target);
+    run("poll", Poller::kPoll, pairs, tokens, target);
+    run("io_uring", Poller::kIoUring, pairs, tokens, target);
+
+    return 0;
+}
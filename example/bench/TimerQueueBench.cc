@@ -0,0 +1,139 @@
+// 对比两种定时器队列：SortedTimerQueue（二叉堆）和 TimerWheel（分层时间轮）
+// 每种规模分别测:
+//   add        添加N个 1~600s 之后到期的定时器（模拟空闲连接超时）
+//   reschedule 每个定时器 cancel + 重新添加（模拟每次收到数据时重置超时）
+//   cancel     取消全部定时器
+//   fire       N个定时器在 200ms 内陆续到期，统计回调的延迟
+// 同时统计前三项平均每次操作的内存分配次数（替换全局operator new计数）
+// 都在loop线程里调用；跨线程的add/cancel要投递回调，还会有std::function和队列节点的分配
+//
+// 用法: ./timer_queue_bench [定时器个数...]   默认 10000 100000 1000000
+
+#include <mynetlib/EventLoop.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+using namespace mynetlib;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<size_t> g_allocs(0);
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// 每次操作的平均分配次数
+static double allocsPerOp(size_t allocsBefore, size_t ops) {
+    return static_cast<double>(g_allocs.load() - allocsBefore) / ops;
+}
+
+struct FireStats {
+    size_t n = 0;
+    size_t fired = 0;
+    size_t early = 0;
+    int64_t totalLateUs = 0;
+    int64_t maxLateUs = 0;
+};
+
+static double nsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+static void bench(TimerQueue::Type type, const char* name, size_t n) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> timeout(1.0, 600.0);
+    std::vector<TimerId> ids(n);
+
+    // 只在构造loop的线程里调用，runAt等会直接在本线程执行，不需要loop()
+    EventLoop loop(Poller::kDefault, type);
+
+    // 模拟连接超时的回调：捕获一个指针和一个整数
+    int dummy = 0;
+    Clock::time_point start = Clock::now();
+    size_t allocs = g_allocs.load();
+    for (size_t i = 0; i < n; ++i) {
+        ids[i] = loop.runAfter(timeout(rng), [&dummy, i] { dummy += static_cast<int>(i); });
+    }
+    double addNs = nsPerOp(start, n);
+    double addAllocs = allocsPerOp(allocs, n);
+
+    start = Clock::now();
+    allocs = g_allocs.load();
+    for (size_t i = 0; i < n; ++i) {
+        loop.cancel(ids[i]);
+        ids[i] = loop.runAfter(timeout(rng), [&dummy, i] { dummy += static_cast<int>(i); });
+    }
+    double rescheduleNs = nsPerOp(start, n);
+    double rescheduleAllocs = allocsPerOp(allocs, n);
+
+    start = Clock::now();
+    allocs = g_allocs.load();
+    for (size_t i = 0; i < n; ++i) {
+        loop.cancel(ids[i]);
+    }
+    double cancelNs = nsPerOp(start, n);
+    double cancelAllocs = allocsPerOp(allocs, n);
+
+    // fire: 0~200ms 之内均匀到期
+    std::uniform_int_distribution<int64_t> delayUs(0, 200 * 1000);
+    FireStats stats;
+    stats.n = n;
+    EventLoop* loopPtr = &loop;
+    Timestamp base = Timestamp::now();
+    for (size_t i = 0; i < n; ++i) {
+        Timestamp when(base.microSecondsSinceEpoch() + delayUs(rng));
+        loop.runAt(when, [&stats, loopPtr, when] {
+            int64_t late = Timestamp::now().microSecondsSinceEpoch() -
+                           when.microSecondsSinceEpoch();
+            if (late < 0) {
+                ++stats.early;
+            }
+            stats.totalLateUs += late;
+            if (late > stats.maxLateUs) {
+                stats.maxLateUs = late;
+            }
+            if (++stats.fired == stats.n) {
+                loopPtr->quit();
+            }
+        });
+    }
+    loop.loop();
+
+    printf("%-6s n=%-8zu add %7.1f ns (%.2f allocs)  reschedule %7.1f ns (%.2f allocs)  "
+           "cancel %7.1f ns (%.2f allocs)  "
+           "fire: avg late %6.1f us, max late %6lld us, early %zu\n",
+           name, n, addNs, addAllocs, rescheduleNs, rescheduleAllocs,
+           cancelNs, cancelAllocs,
+           static_cast<double>(stats.totalLateUs) / n,
+           static_cast<long long>(stats.maxLateUs), stats.early);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(strtoul(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {10000, 100000, 1000000};
+    }
+
+    for (size_t n : sizes) {
+        bench(TimerQueue::kSorted, "sorted", n);
+        bench(TimerQueue::kWheel, "wheel", n);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// 对比普通发送和MSG_ZEROCOPY发送大块数据时IO线程的CPU开销
+// 服务端用writeCompleteCallback不停地发同一个PayloadPtr，客户端读了就丢
+// 输出IO线程（服务端loop所在线程）每发送1GB用掉的CPU时间
+//
+// 注意：发往本机（loopback）的数据内核最终还是要拷贝一次，完成通知会带上COPIED标记，
+// 这种情况下零拷贝省不下CPU，反而多了完成通知的开销；要看到效果，客户端需要在另一台机器上：
+//   服务端: ./zero_copy_bench serve [端口] [消息大小KB]
+//   客户端: 任意读了就丢的程序，比如 nc <服务端IP> <端口> > /dev/null
+//
+// 用法: ./zero_copy_bench [总GB数] [消息大小KB]
+
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mynetlib;
+
+static double threadCpuSeconds() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    if (::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+// 连接建立后一直发送payload，直到发满total字节（total为0表示一直发到对端关闭）
+static TcpServer* startServer(EventLoop* loop, uint16_t port, bool zeroCopy,
+                              const PayloadPtr& payload, size_t total) {
+    TcpServer* server = new TcpServer(loop, InetAddress(port), "bench");
+    if (zeroCopy) {
+        server->setZeroCopy(64 * 1024);
+    }
+    server->setConnectionCallback([=](const TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn->setContext(total);
+            conn->send(payload);
+        }
+    });
+    server->setWriteCompleteCallback([=](const TcpConnectionPtr& conn) {
+        size_t* left = std::any_cast<size_t>(conn->getMutableContext());
+        if (total == 0 || *left > payload->size()) {
+            *left -= payload->size();
+            conn->send(payload);
+        } else {
+            conn->shutdown();
+        }
+    });
+    server->start();
+    return server;
+}
+
+static void bench(bool zeroCopy, uint16_t port, size_t total,
+                  const PayloadPtr& payload) {
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+    TcpServer* server = nullptr;
+    double cpuStart = 0;
+    loop->runInLoop([&] {
+        server = startServer(loop, port, zeroCopy, payload, total);
+        cpuStart = threadCpuSeconds();
+    });
+    ::usleep(100 * 1000);
+
+    auto start = std::chrono::steady_clock::now();
+    int fd = connectTo(port);
+    std::vector<char> buf(1024 * 1024);
+    while (::read(fd, buf.data(), buf.size()) > 0) {
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // 等零拷贝的完成通知都处理完再统计
+    ::usleep(50 * 1000);
+    double cpu = 0;
+    loop->runInLoop([&] { cpu = threadCpuSeconds() - cpuStart; });
+    ::usleep(10 * 1000);
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double gb = static_cast<double>(total) / (1024 * 1024 * 1024);
+    printf("%-9s %6.2f GB  %7.3f s  %8.1f MB/s  io thread cpu %6.3f s  (%.3f s/GB)\n",
+           zeroCopy ? "zerocopy" : "copy", gb, seconds, gb * 1024 / seconds,
+           cpu, cpu / gb);
+
+    ::close(fd);
+    ::usleep(100 * 1000);
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        uint16_t port = argc > 2 ? atoi(argv[2]) : 9995;
+        size_t msgSize = (argc > 3 ? atoi(argv[3]) : 1024) * 1024;
+        EventLoop loop;
+        PayloadPtr payload = std::make_shared<const std::string>(msgSize, 'x');
+        TcpServer* server = startServer(&loop, port, true, payload, 0);
+        loop.loop();
+        delete server;
+        return 0;
+    }
+
+    double gb = argc > 1 ? atof(argv[1]) : 2;
+    size_t msgSize = (argc > 2 ? atoi(argv[2]) : 1024) * 1024;
+    size_t total = static_cast<size_t>(gb * 1024 * 1024 * 1024);
+    PayloadPtr payload = std::make_shared<const std::string>(msgSize, 'x');
+    uint16_t port = 9995;
+
+    bench(false, port++, total, payload);
+    bench(true, port++, total, payload);
+    return 0;
+}
@@ -8,6 +8,12 @@ using namespace mynetlib;
 
 // 用于将HTTP响应的内容追加到指定的缓冲区中
 void HttpResponse::appendToBuffer(mynetlib::Buffer* output) const {
+    appendHeadersToBuffer(output);
+    // 将响应正文 body_ 追加到输出缓冲区 output 中。
+    output->append(body_);
+}
+
+void HttpResponse::appendHeadersToBuffer(mynetlib::Buffer* output) const {
     char buf[32];
     // 创建一个大小为 32 的字符数组 buf，并使用 snprintf()
     // 函数将状态码转换为字符串形式，并拼接到输出缓冲区 output 中
@@ -41,6 +47,4 @@ void HttpResponse::appendToBuffer(mynetlib::Buffer* output) const {
 
     // 添加额外的回车换行符 "\r\n" 到输出缓冲区 output 中，表示头部结束
     output->append("\r\n");
-    // 将响应正文 body_ 追加到输出缓冲区 output 中。
-    output->append(body_);
 }
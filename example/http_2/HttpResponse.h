@@ -50,9 +50,12 @@ public:
 
     // 设置响应的正文内容
     void setBody(const std::string& body) { body_ = body; }
+    const std::string& body() const { return body_; }
 
     // 将响应的内容追加到缓冲区中
     void appendToBuffer(mynetlib::Buffer* output) const;
+    // 只追加状态行和头部（包括头部结束的空行），正文可以单独发送，避免再拷贝一次
+    void appendHeadersToBuffer(mynetlib::Buffer* output) const;
 
 private:
     std::map<std::string, std::string> headers_;
@@ -106,12 +106,18 @@ void HttpServer::onRequest(const TcpConnectionPtr& conn,
     // 作为参数，用于处理 HTTP 请求并生成相应的响应。
     httpCallback_(req, &response);
     mynetlib::Buffer buf;
-    // 创建一个 Buffer 对象 buf，并调用 response 的 appendToBuffer()
-    // 函数，将响应内容添加到 buf 中
-    response.appendToBuffer(&buf);
+    // 创建一个 Buffer 对象 buf，并调用 response 的 appendHeadersToBuffer()
+    // 函数，只把状态行和头部添加到 buf 中
+    response.appendHeadersToBuffer(&buf);
 
-    // 通过调用连接对象的 send() 函数，将 buf 中的数据发送给客户端。
-    conn->send(std::string(buf.peek(), buf.readableBytes()));
+    // 头部和正文作为两段数据，一次writev发送给客户端，不需要先拼接成一个string
+    const std::string& body = response.body();
+    struct iovec vec[2];
+    vec[0].iov_base = const_cast<char*>(buf.peek());
+    vec[0].iov_len = buf.readableBytes();
+    vec[1].iov_base = const_cast<char*>(body.data());
+    vec[1].iov_len = body.size();
+    conn->send(vec, body.empty() ? 1 : 2);
     // 如果响应中指定需要关闭连接，则调用连接对象的 shutdown() 函数关闭连接
     if (response.closeConnection()) {
         conn->shutdown();
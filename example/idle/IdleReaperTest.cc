@@ -0,0 +1,136 @@
+// 空闲连接关闭的测试：TcpServer::setIdleTimeout
+//
+// 客户端连上之后只发1个字节，之后不再发送：
+//   'p' 服务端定时往这个连接推数据（只发不收），超过空闲时间也不能被关闭
+//   'q' 服务端什么也不发，超过空闲时间之后要被关闭
+// 全部符合预期时返回0
+//
+// 用法: ./idletest [IO线程数]
+
+#include <mynetlib/EventLoop.h>
+#include <mynetlib/EventLoopThread.h>
+#include <mynetlib/Logger.h>
+#include <mynetlib/TcpServer.h>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace mynetlib;
+
+static const double kIdleSeconds = 0.4;
+static const double kPushInterval = 0.05;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = *InetAddress(port).getSockAddr();
+    if (::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+// 把fd上已经到达的数据读掉，对端关闭时返回false
+static bool drain(int fd) {
+    char buf[4096];
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (::poll(&pfd, 1, 0) > 0) {
+        ssize_t n = ::read(fd, buf, sizeof buf);
+        if (n <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int ioThreads = argc > 1 ? atoi(argv[1]) : 2;
+    uint16_t port = 9971;
+
+    Logger::setMinLogLevel(ERROR);
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    TcpServer* server = nullptr;
+    loop->runInLoop([&] {
+        server = new TcpServer(loop, InetAddress(port), "idle");
+        server->setThreadNum(ioThreads);
+        server->setIdleTimeout(kIdleSeconds);
+        server->setConnectionCallback([](const TcpConnectionPtr& conn) {
+            // 断开时取消推送的定时器
+            if (!conn->connected() && conn->getContext().has_value()) {
+                conn->getLoop()->cancel(
+                    std::any_cast<TimerId>(conn->getContext()));
+            }
+        });
+        server->setMessageCallback(
+            [](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+                std::string mode = buf->retrieveAllAsString();
+                if (mode == "p" && !conn->getContext().has_value()) {
+                    std::weak_ptr<TcpConnection> weakConn(conn);
+                    conn->setContext(conn->getLoop()->runEvery(
+                        kPushInterval, [weakConn] {
+                            TcpConnectionPtr c = weakConn.lock();
+                            if (c) {
+                                c->send(std::string(64, 'x'));
+                            }
+                        }));
+                }
+            });
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    std::vector<int> pushFds;
+    std::vector<int> quietFds;
+    for (int i = 0; i < 4; ++i) {
+        pushFds.push_back(connectTo(port));
+        quietFds.push_back(connectTo(port));
+        ::write(pushFds.back(), "p", 1);
+        ::write(quietFds.back(), "q", 1);
+    }
+
+    // 等到空闲时间的好几倍，期间只读不写
+    int pushClosed = 0;
+    for (int round = 0; round < 40; ++round) {
+        ::usleep(50 * 1000);
+        for (int& fd : pushFds) {
+            if (fd >= 0 && !drain(fd)) {
+                ++pushClosed;
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    int quietClosed = 0;
+    for (int fd : quietFds) {
+        if (!drain(fd)) {
+            ++quietClosed;
+        }
+        ::close(fd);
+    }
+    for (int fd : pushFds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool ok = pushClosed == 0 && quietClosed == static_cast<int>(quietFds.size());
+    printf("push-only closed %d/%zu (expect 0), quiet closed %d/%zu (expect %zu), "
+           "reaped %ld: %s\n",
+           pushClosed, pushFds.size(), quietClosed, quietFds.size(),
+           quietFds.size(), static_cast<long>(server->numIdleReaped()),
+           ok ? "PASS" : "FAIL");
+
+    loop->runInLoop([&] { delete server; });
+    ::usleep(100 * 1000);
+    return ok ? 0 : 1;
+}
@@ -4,6 +4,8 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -27,9 +29,14 @@ Acceptor::Acceptor(EventLoop* loop,
       acceptSocket_(createNonblocking()),  // socket
       acceptChannel_(loop, acceptSocket_.fd()),
       listenning_(false),
-      idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {
+      idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+      backlog_(1024),
+      maxAcceptsPerEvent_(16),
+      numAccepted_(0),
+      numDropped_(0),
+      numErrors_(0) {
     acceptSocket_.setReuseAddr(true);
-    acceptSocket_.setReusePort(true);
+    acceptSocket_.setReusePort(reuseport);
     acceptSocket_.bindAddress(listenAddr);  // bind套接字
 
     // TcpServer::start() Acceptor.listen
@@ -50,7 +57,7 @@ Acceptor::~Acceptor() {
 void Acceptor::listen() {
     listenning_ = true;
     // listen
-    acceptSocket_.listen();
+    acceptSocket_.listen(backlog_);
     // acceptChannel_ => Poller
     acceptChannel_.enableReading();
 }
@@ -58,35 +65,76 @@ void Acceptor::listen() {
 // listenfd有事件发生了，就是有新用户连接了
 // 接受新连接，并且以负载均衡的选择方式选择一个subEventLoop，
 // 并把这个新连接分发到这个subEventLoop上。
+// 连接风暴时一个事件只accept一个，队列会越积越长，这里一次最多accept maxAcceptsPerEvent_个
 void Acceptor::handleRead() {
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if (connfd >= 0) {
-        if (newConnectionCallback_) {
-            newConnectionCallback_(
-                connfd,
-                peerAddr);  // 轮询找到subLoop，唤醒，分发当前的新客户端的Channel
-        } else {
-            ::close(connfd);
+    for (int i = 0; i < maxAcceptsPerEvent_; ++i) {
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(&peerAddr);
+        if (connfd >= 0) {
+            numAccepted_.fetch_add(1, std::memory_order_relaxed);
+            if (newConnectionCallback_) {
+                newConnectionCallback_(
+                    connfd,
+                    peerAddr);  // 轮询找到subLoop，唤醒，分发当前的新客户端的Channel
+            } else {
+                ::close(connfd);
+            }
+        } else if (!handleAcceptError(errno)) {
+            break;
         }
-    } else {
-        LOG_ERROR("%s:%s:%d accept err:%d \n", __FILE__, __FUNCTION__, __LINE__,
-                  errno);
+    }
+}
 
-        // // 到达上限
-        // if (errno == EMFILE) {
-        //     LOG_ERROR("%s:%s:%d sockfd reached limit! \n", __FILE__,
-        //               __FUNCTION__, __LINE__);
-        // }
+bool Acceptor::handleAcceptError(int savedErrno) {
+    switch (savedErrno) {
+        case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+        case EWOULDBLOCK:
+#endif
+            // 队列已经空了
+            return false;
+        case EINTR:
+        case ECONNABORTED:  // 对端在accept之前就断开了
+        case EPROTO:
+        case EPERM:  // 被防火墙拒绝
+            numErrors_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        case EMFILE:
+        case ENFILE:
+            numErrors_.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERROR("%s:%s:%d sockfd reached limit! \n", __FILE__,
+                      __FUNCTION__, __LINE__);
+            // 设一个空的fd占位，当fd资源都满了后，就释放这个空fd，把来的lfd接受再立马关闭，然后再接着占位
+            // 否则连接一直留在队列里，水平触发下loop会不停地被唤醒
+            if (idleFd_ >= 0) {
+                ::close(idleFd_);
+                int connfd = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+                if (connfd >= 0) {
+                    ::close(connfd);
+                    numDropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+                return connfd >= 0 && idleFd_ >= 0;
+            }
+            return false;
+        default:
+            // ENOBUFS、ENOMEM等，这一轮先不accept了
+            numErrors_.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERROR("%s:%s:%d accept err:%d \n", __FILE__, __FUNCTION__,
+                      __LINE__, savedErrno);
+            return false;
+    }
+}
 
-        // 设一个空的fd占位，当fd资源都满了后，就释放这个空fd，把来的lfd接受再立马关闭，然后再接着占位
-        if (errno == EMFILE) {
-            ::close(idleFd_);
-            ::accept(idleFd_, nullptr, nullptr);
-            ::close(idleFd_);
-            idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
-        }
+int Acceptor::backlogLength() const {
+    // 监听socket的tcpi_unacked是全连接队列的当前长度
+    struct tcp_info info;
+    socklen_t len = sizeof info;
+    if (::getsockopt(acceptSocket_.fd(), IPPROTO_TCP, TCP_INFO, &info, &len) <
+        0) {
+        return -1;
     }
+    return static_cast<int>(info.tcpi_unacked);
 }
 
 }  // namespace mynetlib
@@ -3,6 +3,8 @@
 #include "Socket.h"
 #include "Channel.h"
 
+#include <stdint.h>
+#include <atomic>
 #include <functional>
 
 namespace mynetlib
@@ -23,13 +25,35 @@ public:
         newConnectionCallback_=cb;
     }
 
+    EventLoop* getLoop() const { return loop_; }
+
     bool listening() const {
         return listenning_;
     }
 
+    // 全连接队列的长度，listen之前设置
+    void setBacklog(int backlog) { backlog_ = backlog; }
+    // 一次可读事件最多accept多少个连接，剩下的等下一轮（水平触发会再上报），listen之前设置
+    void setMaxAcceptsPerEvent(int n) { maxAcceptsPerEvent_ = n > 0 ? n : 1; }
+    // 见Socket::setIncomingCpu
+    bool setIncomingCpu(int cpu) { return acceptSocket_.setIncomingCpu(cpu); }
+
     void listen();
+
+    // 统计（任意线程读）
+    // 成功accept的连接数，定时采样两次相减就是建连速率
+    int64_t numAccepted() const { return numAccepted_.load(std::memory_order_relaxed); }
+    // fd用完（EMFILE/ENFILE）时接下来马上关掉的连接数
+    int64_t numDropped() const { return numDropped_.load(std::memory_order_relaxed); }
+    // 除EAGAIN以外accept失败的次数（包括对端在accept之前就断开的ECONNABORTED）
+    int64_t numErrors() const { return numErrors_.load(std::memory_order_relaxed); }
+    // 全连接队列里当前等待accept的连接数，取不到时返回-1
+    int backlogLength() const;
+
 private:
     void handleRead();
+    // accept失败时的处理，返回是否还要接着accept
+    bool handleAcceptError(int savedErrno);
 
     EventLoop *loop_; // Acceptor用的就是用户定义的那个baseLoop，也称作mainLoop
 
@@ -42,6 +66,12 @@ private:
     NewConnectionCallback newConnectionCallback_;   //当loop_里的poller发现acceptSocket_上有事件发生时，向loop_返回acceptChannel_，Acceptor执行此回调
     bool listenning_;
     int idleFd_; //用来解决文件描述符枯竭的情况
+    int backlog_;
+    int maxAcceptsPerEvent_;
+
+    std::atomic<int64_t> numAccepted_;
+    std::atomic<int64_t> numDropped_;
+    std::atomic<int64_t> numErrors_;
 };
 
 
@@ -0,0 +1,140 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <chrono>
+
+namespace mynetlib
+{
+
+AsyncLogging::AsyncLogging(const std::string& basename,
+                           off_t rollSize,
+                           int flushInterval)
+    : flushInterval_(flushInterval),
+      running_(false),
+      basename_(basename),
+      rollSize_(rollSize),
+      thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
+      latch_(1),
+      currentBuffer_(new LogBuffer),
+      nextBuffer_(new LogBuffer),
+      stopped_(false),
+      droppedBuffers_(0) {
+    buffers_.reserve(16);
+}
+
+void AsyncLogging::append(const char* logline, int len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (currentBuffer_->append(logline, len)) {
+        return;
+    }
+    if (stopped_) {
+        // 后台线程已经退出，交出去也没人写，丢掉整块，内存不会随着日志增长
+        ++droppedBuffers_;
+        currentBuffer_->reset();
+        currentBuffer_->append(logline, len);
+        return;
+    }
+    // 当前缓冲区写满了，交给后端
+    buffers_.push_back(std::move(currentBuffer_));
+    if (nextBuffer_) {
+        currentBuffer_ = std::move(nextBuffer_);
+    } else {
+        // 前端写得太快，两块缓冲区都用完了，很少发生
+        currentBuffer_.reset(new LogBuffer);
+    }
+    currentBuffer_->append(logline, len);
+    cond_.notify_one();
+}
+
+void AsyncLogging::start() {
+    running_ = true;
+    thread_.start();
+    latch_.wait();
+}
+
+void AsyncLogging::stop() {
+    {
+        // 加锁再改，避免后台线程刚检查完running_、还没开始wait时错过通知
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void AsyncLogging::threadFunc() {
+    LogFile output(basename_, rollSize_, flushInterval_);
+    // 后端也准备两块空缓冲区，交换时还给前端
+    BufferPtr newBuffer1(new LogBuffer);
+    BufferPtr newBuffer2(new LogBuffer);
+    BufferVector buffersToWrite;
+    buffersToWrite.reserve(16);
+    latch_.countDown();
+
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (buffers_.empty() && running_) {
+                // 不是常规的条件变量用法：超时也要把当前缓冲区写出去
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
+            buffersToWrite.swap(buffers_);
+            if (!nextBuffer_) {
+                nextBuffer_ = std::move(newBuffer2);
+            }
+        }
+
+        // 以下都在锁外
+        if (buffersToWrite.size() > 25) {
+            // 日志堆积太多（前端写得比磁盘快），只保留前两块，其余丢掉
+            char buf[256];
+            snprintf(buf, sizeof buf,
+                     "Dropped log messages at %s, %zu larger buffers\n",
+                     Timestamp::now().toString().c_str(),
+                     buffersToWrite.size() - 2);
+            fputs(buf, stderr);
+            output.append(buf, static_cast<int>(strlen(buf)));
+            droppedBuffers_ += buffersToWrite.size() - 2;
+            buffersToWrite.resize(2);
+        }
+
+        for (const auto& buffer : buffersToWrite) {
+            output.append(buffer->data(), static_cast<int>(buffer->length()));
+        }
+
+        // 留两块缓冲区给newBuffer1/newBuffer2复用，其余释放
+        if (buffersToWrite.size() > 2) {
+            buffersToWrite.resize(2);
+        }
+        if (!newBuffer1) {
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer1->reset();
+        }
+        if (!newBuffer2) {
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer2->reset();
+        }
+        buffersToWrite.clear();
+        output.flush();
+    }
+
+    // 退出前把前端剩下的日志写完，currentBuffer_留给stop之后还在写日志的线程
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : buffers_) {
+        output.append(buffer->data(), static_cast<int>(buffer->length()));
+    }
+    buffers_.clear();
+    output.append(currentBuffer_->data(),
+                  static_cast<int>(currentBuffer_->length()));
+    currentBuffer_->reset();
+    stopped_ = true;
+    output.flush();
+}
+
+}
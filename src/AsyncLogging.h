@@ -0,0 +1,106 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+#include "CountDownLatch.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mynetlib
+{
+
+/**
+ * 异步日志（双缓冲）
+ *
+ * 前端: 各个IO线程调用append，只是把日志拷贝进当前缓冲区（加锁时间很短），不做任何IO
+ * 后端: 一个后台线程，当前缓冲区写满或者每隔flushInterval秒，和前端交换缓冲区，
+ *       然后在锁外把日志写到滚动的LogFile里
+ *
+ * 用法:
+ *   AsyncLogging* g_asyncLog;
+ *   void asyncOutput(const char* msg, int len) { g_asyncLog->append(msg, len); }
+ *   ...
+ *   AsyncLogging log("/tmp/server", 500 * 1000 * 1000);
+ *   g_asyncLog = &log;
+ *   log.start();
+ *   Logger::setOutput(asyncOutput);
+ */
+class AsyncLogging : noncopyable {
+public:
+    AsyncLogging(const std::string& basename,
+                 off_t rollSize,
+                 int flushInterval = 3);
+    ~AsyncLogging() {
+        if (running_) {
+            stop();
+        }
+    }
+
+    // 任意线程调用
+    void append(const char* logline, int len);
+
+    void start();
+    // 停止后台线程，退出前会把已经缓冲的日志全部写完
+    // 之后再写的日志只留在当前缓冲区里，写满了就整块丢掉（计入droppedBuffers），不再分配新缓冲区
+    void stop();
+
+    // 后端处理不过来、或者stop之后写满而被丢弃的日志缓冲区个数
+    int64_t droppedBuffers() const { return droppedBuffers_; }
+
+private:
+    // 固定大小的日志缓冲区
+    class LogBuffer : noncopyable {
+    public:
+        LogBuffer() : cur_(data_) {}
+
+        // 剩余空间不够时返回false，由调用方换一个缓冲区
+        bool append(const char* buf, size_t len) {
+            if (avail() > len) {
+                memcpy(cur_, buf, len);
+                cur_ += len;
+                return true;
+            }
+            return false;
+        }
+
+        const char* data() const { return data_; }
+        size_t length() const { return cur_ - data_; }
+        size_t avail() const { return end() - cur_; }
+        void reset() { cur_ = data_; }
+
+    private:
+        const char* end() const { return data_ + sizeof data_; }
+
+        char data_[4 * 1024 * 1024];
+        char* cur_;
+    };
+
+    using BufferPtr = std::unique_ptr<LogBuffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    void threadFunc();
+
+    const int flushInterval_;
+    std::atomic_bool running_;
+    const std::string basename_;
+    const off_t rollSize_;
+    Thread thread_;
+    CountDownLatch latch_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    BufferPtr currentBuffer_;  // 前端正在写的缓冲区
+    BufferPtr nextBuffer_;     // 预备缓冲区，currentBuffer_写满时直接换上，不用在锁内分配
+    BufferVector buffers_;     // 已经写满、等待后端写出的缓冲区
+    bool stopped_;             // 后台线程已经写完最后的日志退出了，没有人再取走buffers_
+    std::atomic<int64_t> droppedBuffers_;
+};
+
+}
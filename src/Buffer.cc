@@ -9,13 +9,22 @@ namespace mynetlib
 
 
 const char Buffer::kCRLF[] = "\r\n";
+char Buffer::kEmpty[Buffer::kCheapPrepend];
+
+// readv的第二块缓冲区，每个线程一块
+// 以前是栈上的 char extrabuf[65536] = {0}，每次读都要先清零64K，小包的时候这比读本身还贵
+// 放在线程局部存储里只在线程第一次用到时分配一次，也不需要清零（readv会覆盖掉用到的部分）
+static thread_local char t_extrabuf[65536];
 
 /**
  * 从fd上读取数据 Poller工作在LT模式(数据没有读完的话，底层poller会不断地去上报)
  * Buffer缓冲区是有大小的！ 但是从fd上读数据的时候，却不知道tcp数据最终的大小
  */
 ssize_t Buffer::readFd(int fd, int* saveErrno) {
-    char extrabuf[65536] = {0};  // 栈上的内存空间 64K
+    // 空的Buffer没有内存，先从池里拿一块，小包可以直接读进来，不用再从t_extrabuf拷贝一次
+    if (buffer_ == nullptr) {
+        makeSpace(initialSize_);
+    }
     struct iovec vec[2];
 
     const size_t writable =
@@ -26,30 +35,34 @@ ssize_t Buffer::readFd(int fd, int* saveErrno) {
     vec[0].iov_len = writable;
 
     // 第二块缓冲区
-    // 不够填，就要把数据放在栈里面
-    vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof extrabuf;
+    // 不够填，就要把数据先放在线程的extrabuf里面
+    vec[1].iov_base = t_extrabuf;
+    vec[1].iov_len = sizeof t_extrabuf;
 
-    // writable < sizeof extrabuf 表示底层可写的缓冲区空间不够大，用两块
-    const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;
+    // writable < sizeof t_extrabuf 表示底层可写的缓冲区空间不够大，用两块
+    const int iovcnt = (writable < sizeof t_extrabuf) ? 2 : 1;
     // 数组名vec本身就是地址
     // readv可以从文件描述符fd中读取数据到多个缓冲区中，分散读
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0) {
         *saveErrno = errno;
-    } else if (n <= writable)  // Buffer的可写缓冲区已经够存储读出来的数据了
+    } else if (static_cast<size_t>(n) <= writable)  // Buffer的可写缓冲区已经够存储读出来的数据了
     {
         // 读数据writerIndex_后移
         writerIndex_ += n;
     } else {
-        // Buffer空间不够存，需要把溢出的部分（extrabuf）倒到Buffer中（会先触发扩容机制）
-        // extrabuf里面也写入了数据
-        writerIndex_ = buffer_.size();
+        // Buffer空间不够存，需要把溢出的部分（t_extrabuf）倒到Buffer中（会先触发扩容机制）
+        // t_extrabuf里面也写入了数据
+        writerIndex_ = capacity_;
         // Buffer已经存了writable个数据
-        append(extrabuf,
+        append(t_extrabuf,
                n - writable);  // writerIndex_开始写 n - writable大小的数据
     }
 
+    // 什么都没读到（EAGAIN/对端关闭），空的Buffer不留着内存
+    if (n <= 0 && readableBytes() == 0) {
+        releaseSpace();
+    }
     return n;
 }
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "BufferPool.h"
+
+#include <string.h>
 #include <algorithm>
 #include <string>
-#include <vector>
+#include <utility>
 
 namespace mynetlib {
 
@@ -16,6 +19,9 @@ namespace mynetlib {
 /// |                   |                  |                  |
 /// 0      <=      readerIndex   <=   writerIndex    <=     size
 /// @endcode
+///
+/// 内存来自当前线程的BufferPool，按需分配：构造时不分配，数据被取完（retrieveAll）就还给池，
+/// 所以空闲的连接不占缓冲区内存，一次大上传之后也不会一直留着一个大块
 
 // 网络库底层的缓冲器类型定义
 class Buffer {
@@ -27,14 +33,55 @@ public:
 
     // 同样不允许默认生成对象
     // readerIndex_/writerIndex_没有数据先指向一个地方
+    // initialSize是第一次真正分配内存时至少要的大小
     explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize),
+        : buffer_(nullptr),
+          capacity_(0),
+          initialSize_(initialSize),
           readerIndex_(kCheapPrepend),
           writerIndex_(kCheapPrepend) {}
 
+    ~Buffer() { BufferPool::deallocate(buffer_); }
+
+    // 拷贝只拷贝可读的数据
+    Buffer(const Buffer& rhs) : Buffer(rhs.initialSize_) {
+        append(rhs.peek(), rhs.readableBytes());
+    }
+
+    Buffer(Buffer&& rhs) noexcept
+        : buffer_(rhs.buffer_),
+          capacity_(rhs.capacity_),
+          initialSize_(rhs.initialSize_),
+          readerIndex_(rhs.readerIndex_),
+          writerIndex_(rhs.writerIndex_) {
+        rhs.buffer_ = nullptr;
+        rhs.capacity_ = 0;
+        rhs.readerIndex_ = rhs.writerIndex_ = kCheapPrepend;
+    }
+
+    Buffer& operator=(Buffer rhs) {
+        swap(rhs);
+        return *this;
+    }
+
+    // 交换两个Buffer的内容，只交换指针，不拷贝数据
+    void swap(Buffer& rhs) {
+        std::swap(buffer_, rhs.buffer_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(initialSize_, rhs.initialSize_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+    }
+
     size_t readableBytes() const { return writerIndex_ - readerIndex_; }
 
-    size_t writableBytes() const { return buffer_.size() - writerIndex_; }
+    // 还没有分配内存时为0
+    size_t writableBytes() const {
+        return capacity_ > writerIndex_ ? capacity_ - writerIndex_ : 0;
+    }
+
+    // 当前占用的内存大小
+    size_t capacity() const { return capacity_; }
 
     // 0-readerIndex_
     size_t prependableBytes() const { return readerIndex_; }
@@ -58,6 +105,8 @@ public:
     void retrieveAll() {
         // 没的读了，可读的已经读完了，把writerIndex拉到readIndex相当于复位了
         readerIndex_ = writerIndex_ = kCheapPrepend;
+        // 内存还给池，下次要写的时候再拿
+        releaseSpace();
     }
 
     // 把onMessage函数上报的Buffer数据，转成string类型的数据返回
@@ -91,7 +140,9 @@ public:
     void append(const char* data, size_t len) {
         ensureWriteableBytes(len);
         // 把要添加的数据拷贝到可写的缓冲区里面
-        std::copy(data, data + len, beginWrite());
+        if (len > 0) {
+            memcpy(beginWrite(), data, len);
+        }
         // 移动缓冲区可写的起始位置
         writerIndex_ += len;
     }
@@ -127,22 +178,31 @@ public:
     ssize_t writeFd(int fd, int* saveErrno);
 
 private:
-    char* begin() {
-        // it.operator*()
-        // 解引用后取地址
-        // vector底层数组首元素的地址，也就是数组的起始地址
-        // 也可以用buffer_.data()
-        return &*buffer_.begin();
-    }
+    // 还没有分配内存时指向一块空的静态区域，peek()/beginWrite()仍然是合法的指针
+    char* begin() { return buffer_ ? buffer_ : kEmpty; }
 
-    const char* begin() const { return &*buffer_.begin(); }
+    const char* begin() const { return buffer_ ? buffer_ : kEmpty; }
 
     // 扩充写缓冲区空间
     void makeSpace(size_t len) {
-        // 所有剩下可写的还是不够
-        if (writableBytes() + prependableBytes() < len + kCheapPrepend) {
-            // 至少有len的空间有的写
-            buffer_.resize(writerIndex_ + len);
+        // 还没有从池里拿内存（begin()是kEmpty），或者所有剩下可写的还是不够
+        if (buffer_ == nullptr ||
+            writableBytes() + prependableBytes() < len + kCheapPrepend) {
+            // 从池里换一块够大的（至少有len的空间有的写），把可读的数据搬过去
+            size_t readable = readableBytes();
+            size_t capacity = 0;
+            char* block = BufferPool::allocate(
+                std::max(kCheapPrepend + initialSize_,
+                         kCheapPrepend + readable + len),
+                &capacity);
+            if (readable > 0) {
+                memcpy(block + kCheapPrepend, peek(), readable);
+            }
+            BufferPool::deallocate(buffer_);
+            buffer_ = block;
+            capacity_ = capacity;
+            readerIndex_ = kCheapPrepend;
+            writerIndex_ = readerIndex_ + readable;
         } else {
             // 可读的数据
             size_t readalbe = readableBytes();
@@ -155,12 +215,24 @@ private:
         }
     }
 
-    std::vector<char> buffer_;
+    // 把内存还给池（只在没有可读数据时调用）
+    void releaseSpace() {
+        if (buffer_) {
+            BufferPool::deallocate(buffer_);
+            buffer_ = nullptr;
+            capacity_ = 0;
+        }
+    }
+
+    char* buffer_;
+    size_t capacity_;
+    size_t initialSize_;
     // 注意：读写缓冲区都有可读和可写起始位置！！！
     size_t readerIndex_;  // 可读数据起始位置
     size_t writerIndex_;  // 可写入起始位置
 
     static const char kCRLF[];
+    static char kEmpty[kCheapPrepend];
 };
 
 }  // namespace mynetlib
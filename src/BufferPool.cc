@@ -0,0 +1,138 @@
+#include "BufferPool.h"
+
+#include <stdlib.h>
+#include <new>
+
+namespace mynetlib
+{
+
+// 块头，16字节，后面紧跟着可用的内存
+struct BufferPool::BlockHeader {
+    BufferPool* owner;
+    union {
+        size_t capacity;    // 分配出去时：可用大小
+        BlockHeader* next;  // 在空闲链表里时：下一个空闲块（大小由所在的级别决定）
+    };
+};
+
+static_assert(sizeof(void*) * 2 == 16, "BlockHeader is expected to be 16 bytes");
+
+// 线程退出时清空本线程池的缓存
+struct BufferPoolThreadGuard {
+    BufferPool* pool = nullptr;
+    ~BufferPoolThreadGuard() {
+        if (pool) {
+            pool->trim();
+        }
+    }
+};
+
+static thread_local BufferPoolThreadGuard t_bufferPool;
+
+BufferPool::BufferPool()
+    : maxCachedBytes_(kDefaultMaxCachedBytes),
+      bytesInUse_(0),
+      bytesCached_(0),
+      numMallocs_(0),
+      exited_(false),
+      refs_(1) {
+    for (int i = 0; i < kNumClasses; ++i) {
+        freeLists_[i] = nullptr;
+    }
+}
+
+BufferPool* BufferPool::current() {
+    if (t_bufferPool.pool == nullptr) {
+        t_bufferPool.pool = new BufferPool;
+    }
+    return t_bufferPool.pool;
+}
+
+int BufferPool::sizeClass(size_t size) {
+    if (size > kMaxPooledSize) {
+        return -1;
+    }
+    int cls = 0;
+    size_t blockSize = kMinBlockSize;
+    while (blockSize < size) {
+        blockSize <<= 1;
+        ++cls;
+    }
+    return cls;
+}
+
+char* BufferPool::allocate(size_t size, size_t* capacity) {
+    return current()->allocateBlock(size, capacity);
+}
+
+void BufferPool::deallocate(char* block) {
+    if (block) {
+        BlockHeader* header = reinterpret_cast<BlockHeader*>(block) - 1;
+        header->owner->deallocateBlock(header);
+    }
+}
+
+char* BufferPool::allocateBlock(size_t size, size_t* capacity) {
+    int cls = sizeClass(size);
+    size_t blockSize = cls < 0 ? size : kMinBlockSize << cls;
+    BlockHeader* header = nullptr;
+    if (cls >= 0 && freeLists_[cls]) {
+        header = freeLists_[cls];
+        freeLists_[cls] = header->next;
+        bytesCached_.fetch_sub(blockSize, std::memory_order_relaxed);
+    } else {
+        header = static_cast<BlockHeader*>(::malloc(sizeof(BlockHeader) + blockSize));
+        if (header == nullptr) {
+            throw std::bad_alloc();
+        }
+        header->owner = this;
+        numMallocs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    header->capacity = blockSize;
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    bytesInUse_.fetch_add(blockSize, std::memory_order_relaxed);
+    *capacity = blockSize;
+    return reinterpret_cast<char*>(header + 1);
+}
+
+void BufferPool::deallocateBlock(BlockHeader* header) {
+    size_t blockSize = header->capacity;
+    bytesInUse_.fetch_sub(blockSize, std::memory_order_relaxed);
+    int cls = sizeClass(blockSize);
+    // 只有所属线程可以碰空闲链表
+    if (cls >= 0 && this == t_bufferPool.pool && !exited_ &&
+        bytesCached() + static_cast<int64_t>(blockSize) <=
+            static_cast<int64_t>(maxCachedBytes())) {
+        header->next = freeLists_[cls];
+        freeLists_[cls] = header;
+        bytesCached_.fetch_add(blockSize, std::memory_order_relaxed);
+    } else {
+        ::free(header);
+    }
+    unref();
+}
+
+void BufferPool::setMaxCachedBytes(size_t bytes) {
+    maxCachedBytes_.store(bytes, std::memory_order_relaxed);
+}
+
+void BufferPool::trim() {
+    exited_ = true;
+    for (int i = 0; i < kNumClasses; ++i) {
+        while (freeLists_[i]) {
+            BlockHeader* header = freeLists_[i];
+            freeLists_[i] = header->next;
+            ::free(header);
+        }
+    }
+    bytesCached_.store(0, std::memory_order_relaxed);
+    unref();
+}
+
+void BufferPool::unref() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace mynetlib
+{
+
+/**
+ * 缓冲区内存池，每个线程一个（loop线程的池就是这个EventLoop的池，见EventLoop::bufferPool）
+ *
+ * 按2的幂分级：1KB、2KB ... 4MB，每级一个空闲链表；更大的块直接malloc/free
+ * Buffer和ChainBuffer的内存都从这里来，空了就还回来，空闲的连接不占缓冲区内存
+ *
+ * 每个块前面有一个小块头记录所属的池和大小，在哪个线程释放都可以：
+ * 所属线程释放的块放回空闲链表，其他线程释放的直接free，只更新所属池的统计
+ * 每个分配出去的块都持有池的一个引用，线程退出时池只清空缓存，等最后一个块释放之后才删除
+ */
+class BufferPool : noncopyable {
+public:
+    static const size_t kMinBlockSize = 1024;
+    static const size_t kMaxPooledSize = 4 * 1024 * 1024;
+    // 默认每个线程最多缓存这么多空闲内存，多的直接还给系统
+    static const size_t kDefaultMaxCachedBytes = 16 * 1024 * 1024;
+
+    // 当前线程的池
+    static BufferPool* current();
+
+    // 分配至少size字节的块，*capacity返回实际可用的大小
+    static char* allocate(size_t size, size_t* capacity);
+    // 任意线程都可以调用
+    static void deallocate(char* block);
+
+    // 空闲链表最多缓存多少字节
+    void setMaxCachedBytes(size_t bytes);
+    size_t maxCachedBytes() const {
+        return maxCachedBytes_.load(std::memory_order_relaxed);
+    }
+
+    // 以下统计可以在任意线程读取
+    // 分配出去还没有释放的字节数
+    int64_t bytesInUse() const {
+        return bytesInUse_.load(std::memory_order_relaxed);
+    }
+    // 空闲链表里缓存的字节数
+    int64_t bytesCached() const {
+        return bytesCached_.load(std::memory_order_relaxed);
+    }
+    // 从系统（malloc）分配的次数，命中空闲链表的不算
+    int64_t numMallocs() const {
+        return numMallocs_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct BlockHeader;
+
+    static const int kNumClasses = 13;  // 1KB ~ 4MB
+
+    BufferPool();
+    ~BufferPool() = default;
+
+    static int sizeClass(size_t size);
+    char* allocateBlock(size_t size, size_t* capacity);
+    void deallocateBlock(BlockHeader* header);
+    // 线程退出时把缓存还给系统
+    void trim();
+    void unref();
+
+    friend struct BufferPoolThreadGuard;
+
+    BlockHeader* freeLists_[kNumClasses];
+    std::atomic<size_t> maxCachedBytes_;
+    std::atomic<int64_t> bytesInUse_;
+    std::atomic<int64_t> bytesCached_;
+    std::atomic<int64_t> numMallocs_;
+    bool exited_;  // 线程已经退出，不再缓存
+    // 所属线程一个 + 每个分配出去的块一个
+    std::atomic<int64_t> refs_;
+};
+
+}
@@ -3,6 +3,9 @@
 // 智能指针的头文件
 #include <functional>
 #include <memory>
+#include <string>
+
+#include "SmallFunction.h"
 
 namespace mynetlib
 {
@@ -22,7 +25,12 @@ using MessageCallback =
     std::function<void(const TcpConnectionPtr&, Buffer*, Timestamp)>;
 
 using HighWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
+using LowWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
+
+// 不可变的共享发送数据：同一份响应发给多个连接、或者从工作线程转交给IO线程时，只增加引用计数
+using PayloadPtr = std::shared_ptr<const std::string>;
 
-using TimerCallback = std::function<void()>;
+// 定时器回调用带小缓冲区的SmallFunction，捕获几个变量的lambda不用分配内存
+using TimerCallback = SmallFunction<void()>;
 
 }
\ No newline at end of file
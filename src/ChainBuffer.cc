@@ -0,0 +1,261 @@
+#include "ChainBuffer.h"
+#include "BufferPool.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <utility>
+
+namespace mynetlib {
+
+struct ChainBuffer::Chunk {
+    static const size_t kCapacity;
+
+    Chunk* next;
+    size_t read;   // 可读起始位置
+    size_t write;  // 可写起始位置
+    char data[1];  // 实际大小是kCapacity
+
+    size_t readable() const { return write - read; }
+    size_t writable() const { return kCapacity - write; }
+};
+
+const size_t ChainBuffer::Chunk::kCapacity =
+    ChainBuffer::kChunkSize - offsetof(ChainBuffer::Chunk, data);
+
+ChainBuffer::Chunk* ChainBuffer::newChunk() {
+    size_t capacity;
+    Chunk* chunk =
+        reinterpret_cast<Chunk*>(BufferPool::allocate(kChunkSize, &capacity));
+    chunk->next = nullptr;
+    chunk->read = 0;
+    chunk->write = 0;
+    return chunk;
+}
+
+void ChainBuffer::deleteChunk(Chunk* chunk) {
+    BufferPool::deallocate(reinterpret_cast<char*>(chunk));
+}
+
+ChainBuffer::ChainBuffer()
+    : head_(nullptr), tail_(nullptr), readable_(0), numChunks_(0) {}
+
+ChainBuffer::~ChainBuffer() {
+    while (head_) {
+        freeHead();
+    }
+}
+
+ChainBuffer::ChainBuffer(ChainBuffer&& that) noexcept
+    : head_(that.head_),
+      tail_(that.tail_),
+      readable_(that.readable_),
+      numChunks_(that.numChunks_) {
+    that.head_ = that.tail_ = nullptr;
+    that.readable_ = that.numChunks_ = 0;
+}
+
+ChainBuffer& ChainBuffer::operator=(ChainBuffer&& that) noexcept {
+    if (this != &that) {
+        while (head_) {
+            freeHead();
+        }
+        std::swap(head_, that.head_);
+        std::swap(tail_, that.tail_);
+        std::swap(readable_, that.readable_);
+        std::swap(numChunks_, that.numChunks_);
+    }
+    return *this;
+}
+
+void ChainBuffer::linkChunk(Chunk* chunk) {
+    if (tail_) {
+        tail_->next = chunk;
+    } else {
+        head_ = chunk;
+    }
+    tail_ = chunk;
+    ++numChunks_;
+}
+
+ChainBuffer::Chunk* ChainBuffer::appendChunk() {
+    Chunk* chunk = newChunk();
+    linkChunk(chunk);
+    return chunk;
+}
+
+void ChainBuffer::freeHead() {
+    Chunk* chunk = head_;
+    head_ = chunk->next;
+    if (head_ == nullptr) {
+        tail_ = nullptr;
+    }
+    --numChunks_;
+    deleteChunk(chunk);
+}
+
+const char* ChainBuffer::peek() const {
+    return head_ ? head_->data + head_->read : nullptr;
+}
+
+size_t ChainBuffer::peekableBytes() const {
+    return head_ ? head_->readable() : 0;
+}
+
+void ChainBuffer::retrieve(size_t len) {
+    if (len >= readable_) {
+        retrieveAll();
+        return;
+    }
+    readable_ -= len;
+    while (len > 0) {
+        size_t n = std::min(len, head_->readable());
+        head_->read += n;
+        len -= n;
+        if (head_->readable() == 0) {
+            freeHead();
+        }
+    }
+}
+
+void ChainBuffer::retrieveAll() {
+    // 空了就把所有的块都还给池，空闲的连接不占内存（从池里再拿一块很便宜）
+    while (head_) {
+        freeHead();
+    }
+    readable_ = 0;
+}
+
+std::string ChainBuffer::retrieveAsString(size_t len) {
+    len = std::min(len, readable_);
+    std::string result(len, '\0');
+    copyOut(&result[0], len);
+    retrieve(len);
+    return result;
+}
+
+void ChainBuffer::append(const char* data, size_t len) {
+    readable_ += len;
+    while (len > 0) {
+        Chunk* chunk = tail_;
+        if (chunk == nullptr || chunk->writable() == 0) {
+            chunk = appendChunk();
+        }
+        size_t n = std::min(len, chunk->writable());
+        memcpy(chunk->data + chunk->write, data, n);
+        chunk->write += n;
+        data += n;
+        len -= n;
+    }
+}
+
+size_t ChainBuffer::findCRLF(size_t start) const {
+    size_t offset = 0;  // 当前块第一个可读字节的偏移
+    bool prevCR = false;  // 上一块的最后一个字节是不是'\r'（不早于start）
+    for (const Chunk* chunk = head_; chunk; chunk = chunk->next) {
+        const char* begin = chunk->data + chunk->read;
+        size_t len = chunk->readable();
+        if (offset + len > start) {
+            if (prevCR && len > 0 && begin[0] == '\n') {
+                return offset - 1;
+            }
+            size_t skip = start > offset ? start - offset : 0;
+            const char* from = begin + skip;
+            const char* end = begin + len;
+            const char* cr = from;
+            while ((cr = static_cast<const char*>(memchr(cr, '\r', end - cr)))) {
+                if (cr + 1 < end) {
+                    if (cr[1] == '\n') {
+                        return offset + (cr - begin);
+                    }
+                    ++cr;
+                } else {
+                    break;
+                }
+            }
+            prevCR = len > 0 && end[-1] == '\r';
+        }
+        offset += len;
+    }
+    return npos;
+}
+
+void ChainBuffer::copyOut(char* dst, size_t len) const {
+    for (const Chunk* chunk = head_; chunk && len > 0; chunk = chunk->next) {
+        size_t n = std::min(len, chunk->readable());
+        memcpy(dst, chunk->data + chunk->read, n);
+        dst += n;
+        len -= n;
+    }
+}
+
+ssize_t ChainBuffer::readFd(int fd, int* saveErrno) {
+    // 最后一块剩下的空间 + 一个新块，新块读不满时还回去
+    // 最后一块已经满了（或者还没有块）时先用一个新块代替，读到数据才接到链表上
+    Chunk* last = tail_;
+    Chunk* fresh = nullptr;
+    if (last == nullptr || last->writable() == 0) {
+        fresh = newChunk();
+        last = fresh;
+    }
+    Chunk* extra = newChunk();
+
+    struct iovec vec[2];
+    vec[0].iov_base = last->data + last->write;
+    vec[0].iov_len = last->writable();
+    vec[1].iov_base = extra->data;
+    vec[1].iov_len = Chunk::kCapacity;
+
+    const ssize_t n = ::readv(fd, vec, 2);
+    if (n < 0) {
+        *saveErrno = errno;
+    } else if (n > 0) {
+        if (fresh) {
+            linkChunk(fresh);
+            fresh = nullptr;
+        }
+        size_t first = std::min(static_cast<size_t>(n), last->writable());
+        last->write += first;
+        readable_ += n;
+        if (static_cast<size_t>(n) > first) {
+            extra->write = n - first;
+            linkChunk(extra);
+            extra = nullptr;
+        }
+    }
+    if (fresh) {
+        deleteChunk(fresh);
+    }
+    if (extra) {
+        deleteChunk(extra);
+    }
+    return n;
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int* saveErrno, size_t maxBytes) {
+    struct iovec vec[kMaxIov];
+    int iovcnt = 0;
+    for (Chunk* chunk = head_; chunk && iovcnt < kMaxIov && maxBytes > 0;
+         chunk = chunk->next) {
+        if (chunk->readable() > 0) {
+            size_t n = std::min(chunk->readable(), maxBytes);
+            vec[iovcnt].iov_base = chunk->data + chunk->read;
+            vec[iovcnt].iov_len = n;
+            maxBytes -= n;
+            ++iovcnt;
+        }
+    }
+    if (iovcnt == 0) {
+        return 0;
+    }
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0) {
+        *saveErrno = errno;
+    }
+    return n;
+}
+
+}  // namespace mynetlib
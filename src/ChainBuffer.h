@@ -0,0 +1,88 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <sys/types.h>
+#include <string>
+
+namespace mynetlib {
+
+/// 分段的缓冲区：由固定大小的块串成的链表
+///
+/// @code
+///  head_                                        tail_
+///  +--------------+     +--------------+     +--------------+
+///  | ... |readable| --> |   readable   | --> |readable| ... |
+///  +--------------+     +--------------+     +--------------+
+///       read               (整块可读)             write
+/// @endcode
+///
+/// 和Buffer的区别：append只往最后一块后面写，写满了就挂一个新块，
+/// 已有的数据永远不会被搬动（Buffer扩容时要resize+拷贝，或者memmove到前面）；
+/// 发送时用writev一次把多个块交给内核。
+/// 块来自线程的BufferPool，全部发完/取完之后马上还回去。
+///
+/// 数据在内存中不连续，peek()只能拿到第一块里的数据，
+/// findCRLF返回的是相对可读起始位置的偏移
+class ChainBuffer : noncopyable {
+public:
+    // 每一块的大小（包括块头）
+    static const size_t kChunkSize = 16 * 1024;
+    static const size_t npos = static_cast<size_t>(-1);
+
+    ChainBuffer();
+    ~ChainBuffer();
+
+    ChainBuffer(ChainBuffer&& that) noexcept;
+    ChainBuffer& operator=(ChainBuffer&& that) noexcept;
+
+    size_t readableBytes() const { return readable_; }
+
+    // 第一块中可读数据的起始地址和长度
+    const char* peek() const;
+    size_t peekableBytes() const;
+
+    void retrieve(size_t len);
+    void retrieveAll();
+    std::string retrieveAsString(size_t len);
+    std::string retrieveAllAsString() { return retrieveAsString(readableBytes()); }
+
+    void append(const std::string& str) { append(str.data(), str.size()); }
+    void append(const char* data, size_t len);
+
+    // 从可读起始位置偏移start处开始找 "\r\n"，返回它的偏移，找不到返回npos
+    size_t findCRLF(size_t start = 0) const;
+
+    // 把前len个字节拷贝到dst（不取出）
+    void copyOut(char* dst, size_t len) const;
+
+    // 直接读到最后一块和新的块里，不经过中间缓冲区
+    ssize_t readFd(int fd, int* saveErrno);
+    // writev发送，一次最多kMaxIov块，最多发送maxBytes字节
+    ssize_t writeFd(int fd, int* saveErrno, size_t maxBytes = npos);
+
+    // 当前挂着的块数
+    size_t numChunks() const { return numChunks_; }
+
+private:
+    struct Chunk;
+
+    static const int kMaxIov = 64;
+
+    // 块的内存来自当前线程的BufferPool
+    // newChunk返回的是空块（next为空，没有数据）
+    static Chunk* newChunk();
+    static void deleteChunk(Chunk* chunk);
+
+    // 把一个块接到链表尾部
+    void linkChunk(Chunk* chunk);
+    Chunk* appendChunk();
+    void freeHead();
+
+    Chunk* head_;
+    Chunk* tail_;
+    size_t readable_;
+    size_t numChunks_;
+};
+
+}  // namespace mynetlib
@@ -13,6 +13,7 @@ const int Channel::kNoneEvent = 0;
 // EPOLLPRI紧急数据到达
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI;
 const int Channel::kWriteEvent = EPOLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
 
 // EventLoop: ChannelList Poller
 Channel::Channel(EventLoop* loop, int fd)
@@ -21,6 +22,8 @@ Channel::Channel(EventLoop* loop, int fd)
       events_(0),
       revents_(0),
       index_(-1),
+      deferredRevents_(0),
+      edgeTriggered_(false),
       tied_(false),
       eventHandling_(false),
       addedToLoop_(false) {}
@@ -82,8 +85,8 @@ void Channel::handleEvent(Timestamp receiveTime) {
 // 根据poller通知的channel发生的具体事件，由channel负责调用具体的回调操作
 void Channel::handleEventWithGuard(Timestamp receiveTime) {
     // __FUNCTION__   __LINE__ 内带的宏，打印函数、行号
-    // 打印日志信息
-    LOG_INFO("channel handleEvent revents:%d\n", revents_);
+    // 打印日志信息，每个事件都会执行，只在TRACE级别输出
+    LOG_TRACE("channel handleEvent revents:%d\n", revents_);
     eventHandling_ = true;
     // EPOLLHUP：挂起或者关闭，也就是读写都关闭
     if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) {
@@ -50,9 +50,16 @@ public:
     void tie(const std::shared_ptr<void>&);
 
     int fd() const { return fd_; }
-    int events() const { return events_; }
+    // 交给poller注册的事件，边沿触发模式下带上EPOLLET
+    int events() const {
+        return edgeTriggered_ ? (events_ | kEdgeTriggered) : events_;
+    }
     // 设置具体发生的事件
     void set_revents(int revt) { revents_ = revt; }
+    int revents() const { return revents_; }
+    // 超出时间预算、推迟到下一轮处理的事件（由EventLoop维护，0表示没有）
+    int deferredRevents() const { return deferredRevents_; }
+    void set_deferredRevents(int revt) { deferredRevents_ = revt; }
 
     // 设置fd相应的事件状态
     // 相应的readevent置位
@@ -80,6 +87,17 @@ public:
         update();
     }
 
+    // 边沿触发（EPOLLET），默认是水平触发
+    // 已经注册了事件的话立即生效，否则在下一次enableXXX时生效
+    // 打开以后，读写回调必须一直读/写到EAGAIN为止
+    void setEdgeTriggered(bool on) {
+        edgeTriggered_ = on;
+        if (!isNoneEvent()) {
+            update();
+        }
+    }
+    bool isEdgeTriggered() const { return edgeTriggered_; }
+
     // 返回fd当前的事件状态
     bool isNoneEvent() const { return events_ == kNoneEvent; }
     // 相与后还为1，说明确实有这个事件
@@ -103,13 +121,16 @@ private:
     static const int kNoneEvent; 
     static const int kReadEvent;
     static const int kWriteEvent;
+    static const int kEdgeTriggered;
 
     EventLoop* loop_;  // 事件循环
     const int fd_;     // fd, Poller监听的对象，epoll_ctrl
     int events_;       // 注册fd感兴趣的事件
     int revents_;      // poller返回的具体发生的事件
     int index_;        // 表示Channel在Poller上的状态
+    int deferredRevents_;  // 推迟到下一轮处理的事件
 
+    bool edgeTriggered_; // 是否使用边沿触发
     bool eventHandling_; //标志着是否正在处理事件，防止析构一个正在处理事件的Channel
     bool addedToLoop_;  // 标志着Channel是否在Loop的ChannelLists，也即是否被添加
 
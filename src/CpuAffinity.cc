@@ -0,0 +1,84 @@
+#include "CpuAffinity.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mynetlib
+{
+namespace CpuAffinity
+{
+
+// <numaif.h>属于libnuma，这里只需要两个常量
+static const int kMpolPreferred = 1;
+
+int numCpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof set, &set) == 0)
+    {
+        return CPU_COUNT(&set);
+    }
+    return static_cast<int>(::sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+int currentCpu()
+{
+    return ::sched_getcpu();
+}
+
+bool pinCurrentThread(int cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+    if (err != 0)
+    {
+        LOG_ERROR("CpuAffinity::pinCurrentThread cpu=%d err=%d \n", cpu, err);
+        return false;
+    }
+    return true;
+}
+
+int nodeOfCpu(int cpu)
+{
+    // /sys/devices/system/cpu/cpuN/ 下面有一个 nodeM 的链接
+    for (int node = 0; node < 64; ++node)
+    {
+        char path[96];
+        snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if (::access(path, F_OK) == 0)
+        {
+            return node;
+        }
+    }
+    return -1;
+}
+
+bool preferNode(int node)
+{
+    if (node < 0 || node >= 64)
+    {
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    if (::syscall(SYS_set_mempolicy, kMpolPreferred, &mask, sizeof(mask) * 8) != 0)
+    {
+        LOG_ERROR("CpuAffinity::preferNode node=%d errno=%d \n", node, errno);
+        return false;
+    }
+    return true;
+}
+
+}
+}
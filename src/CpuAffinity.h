@@ -0,0 +1,26 @@
+#pragma once
+
+// 封装线程绑核、NUMA内存策略相关的系统调用（不依赖libnuma）
+
+namespace mynetlib
+{
+namespace CpuAffinity
+{
+    // 当前进程可以使用的CPU个数
+    int numCpus();
+
+    // 当前线程正在哪个CPU上运行，失败返回-1
+    int currentCpu();
+
+    // 把当前线程绑定到cpu上，失败返回false
+    bool pinCurrentThread(int cpu);
+
+    // cpu所在的NUMA节点，取不到（非NUMA机器、没有sysfs）返回-1
+    int nodeOfCpu(int cpu);
+
+    // 当前线程之后分配的内存优先从node上分配（MPOL_PREFERRED，不够时退回其他节点），失败返回false
+    // Linux默认已经是在第一次访问内存的CPU所在节点上分配，
+    // 这里是为了绑核之后，线程之前没在本节点上跑过时也一样
+    bool preferNode(int node);
+}
+}
@@ -1,5 +1,8 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#include "IoUringPoller.h"
+#include "PollPoller.h"
+#include "Logger.h"
 
 #include <stdlib.h>
 
@@ -15,13 +18,38 @@ Poller* Poller::newDefaultPoller(EventLoop *loop){
     // 全局函数，没有任何命名空间
     if (::getenv("MUDUO_USE_POLL"))
     {
-        return nullptr; // 生成poll的实例
+        return newPoller(loop, kPoll); // 生成poll的实例
+    }
+    else if (::getenv("MUDUO_USE_URING"))
+    {
+        return newPoller(loop, kIoUring); // 生成io_uring的实例
     }
     else
     {
         // 默认生成epoll复用实例
-        return new EPollPoller(loop); // 生成epoll的实例
+        return newPoller(loop, kEPoll); // 生成epoll的实例
+    }
+}
+
+Poller* Poller::newPoller(EventLoop *loop, Type type){
+    switch (type)
+    {
+    case kPoll:
+        return new PollPoller(loop);
+    case kIoUring:
+        // 内核不支持时退回epoll
+        if (IoUringPoller::supported())
+        {
+            return new IoUringPoller(loop);
+        }
+        LOG_ERROR("io_uring is not supported, fall back to epoll \n");
+        return new EPollPoller(loop);
+    case kEPoll:
+        return new EPollPoller(loop);
+    case kDefault:
+    default:
+        return newDefaultPoller(loop);
     }
-} 
+}
 
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "TimerQueue.h"
+#include "SortedTimerQueue.h"
+#include "TimerWheel.h"
+
+#include <stdlib.h>
+
+namespace mynetlib
+{
+
+// 和DefaulPoller.cc一样，基类TimerQueue不依赖具体实现，工厂函数放在这里
+TimerQueue* TimerQueue::newDefaultTimerQueue(EventLoop* loop)
+{
+    if (::getenv("MUDUO_USE_TIMER_WHEEL"))
+    {
+        return newTimerQueue(loop, kWheel);
+    }
+    return newTimerQueue(loop, kSorted);
+}
+
+TimerQueue* TimerQueue::newTimerQueue(EventLoop* loop, Type type)
+{
+    switch (type)
+    {
+    case kWheel:
+        return new TimerWheel(loop);
+    case kSorted:
+        return new SortedTimerQueue(loop);
+    case kDefault:
+    default:
+        return newDefaultTimerQueue(loop);
+    }
+}
+
+}
@@ -34,9 +34,9 @@ EPollPoller::~EPollPoller() {
 }
 
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
-    // 实际上应该用LOG_DEBUG输出日志更为合理
-    LOG_INFO("func=%s => fd total count:%lu \n", __FUNCTION__,
-             channels_.size());
+    // 每轮循环都会执行，只在TRACE级别输出
+    LOG_TRACE("func=%s => fd total count:%lu \n", __FUNCTION__,
+              channels_.size());
 
     // &*events_.begin()数组的起始地址
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(),
@@ -47,7 +47,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
 
     if (numEvents > 0) {
         // 发生事件的个数
-        LOG_INFO("%d events happened \n", numEvents);
+        LOG_TRACE("%d events happened \n", numEvents);
         // 将活跃(有事件发生的)Channel添加到所属eventloop中的ChannelList中
         fillActiveChannels(numEvents, activeChannels);
         if (numEvents == events_.size()) {
@@ -55,7 +55,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
             events_.resize(events_.size() * 2);
         }
     } else if (numEvents == 0) {
-        LOG_DEBUG("%s timeout! \n", __FUNCTION__);
+        LOG_TRACE("%s timeout! \n", __FUNCTION__);
     } else {
         if (saveErrno != EINTR) {
             errno = saveErrno;
@@ -79,8 +79,8 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
 void EPollPoller::updateChannel(Channel* channel) {
     const int index = channel->index();
     // 体现具体的函数
-    LOG_INFO("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__,
-             channel->fd(), channel->events(), index);
+    LOG_TRACE("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__,
+              channel->fd(), channel->events(), index);
 
     // 未添加或者已删除
     if (index == kNew || index == kDeleted) {
@@ -114,7 +114,7 @@ void EPollPoller::removeChannel(Channel* channel) {
     int fd = channel->fd();
     channels_.erase(fd);
 
-    LOG_INFO("func=%s => fd=%d\n", __FUNCTION__, fd);
+    LOG_TRACE("func=%s => fd=%d\n", __FUNCTION__, fd);
 
     int index = channel->index();
     assert(index == kAdded || index == kDeleted);
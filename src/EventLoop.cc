@@ -34,17 +34,27 @@ int createEventfd() {
 
 // wakeupFd_(createEventfd())：生成一个eventfd，每个EventLoop对象，都会有自己的eventfd
 // threadId_(CurrentThread::tid())：当前lop的线程是构造时的线程
-EventLoop::EventLoop()
+EventLoop::EventLoop(Poller::Type pollerType, TimerQueue::Type timerQueueType)
     : looping_(false),
       quit_(false),
       eventHandling_(false),
       callingPendingFunctors_(false),
       threadId_(CurrentThread::tid()),
-      poller_(Poller::newDefaultPoller(this)),
-      timerQueue_(new TimerQueue(this)),
+      iteration_(0),
+      poller_(Poller::newPoller(this, pollerType)),
+      timerQueue_(TimerQueue::newTimerQueue(this, timerQueueType)),
       wakeupFd_(createEventfd()),
       wakeupChannel_(new Channel(this, wakeupFd_)),
-      currentActiveChannel_(nullptr) {
+      wakeupPending_(false),
+      wakeupsIssued_(0),
+      wakeupsSuppressed_(0),
+      currentActiveChannel_(nullptr),
+      bufferPool_(BufferPool::current()),
+      eventTimeBudget_(0),
+      deferredEvents_(0),
+      latencyStats_(false),
+      numPendingFunctors_(0),
+      numConnections_(0) {
     LOG_DEBUG("EventLoop created %p in thread %d \n", this, threadId_);
     // 如果当前线程已经绑定了某个EventLoop对象了，那么该线程就无法创建新的EventLoop对象了
     if (t_loopInThisThread) {
@@ -80,15 +90,22 @@ void EventLoop::loop() {
         activeChannels_.clear();
         // 监听两类fd，一种是client的fd，一种wakeupfd(mainReactor和subReactor通信用)
         // 此时activeChannels_已经填好了事件发生的channel
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        // 上一轮有推迟的事件时不阻塞，只看一下有没有新的事件（定时器、唤醒等）
+        pollReturnTime_ = poller_->poll(
+            deferredChannels_.empty() ? kPollTimeMs : 0, &activeChannels_);
+        ++iteration_;
         eventHandling_ = true;
-        for (Channel* channel : activeChannels_) {
-            currentActiveChannel_ = channel;
-            // Poller监听哪些channel发生事件了，然后上报给EventLoop，通知channel处理相应的事件
-            currentActiveChannel_->handleEvent(pollReturnTime_);
-        }
+        handleActiveChannels();
         currentActiveChannel_ = nullptr;
         eventHandling_ = false;
+        // 这一轮开始时是否统计（回调里可能会打开/关闭统计）
+        const bool latencyStats = latencyStats_;
+        Timestamp functorsStart;
+        if (latencyStats) {
+            functorsStart = Timestamp::now();
+            eventHandlingLatency_.add(functorsStart.microSecondsSinceEpoch() -
+                                      pollReturnTime_.microSecondsSinceEpoch());
+        }
         // 执行当前EventLoop事件循环需要处理的回调操作
         /**
          * mainloop只做accept
@@ -97,10 +114,62 @@ void EventLoop::loop() {
          * 通过 wakeupChannel_唤醒 subloop后，执行下面的方法，执行之前mainloop注册的cb操作
          */
         doPendingFunctors();
+        if (latencyStats) {
+            pendingFunctorsLatency_.add(
+                Timestamp::now().microSecondsSinceEpoch() -
+                functorsStart.microSecondsSinceEpoch());
+        }
     }
     LOG_INFO("EventLoop %p stop looping. \n", this);
     looping_ = false;
 }
+void EventLoop::handleActiveChannels() {
+    if (!deferredChannels_.empty()) {
+        // 推迟的channel这一轮又有新事件的，合并成一次处理
+        for (Channel* channel : activeChannels_) {
+            if (channel->deferredRevents()) {
+                channel->set_revents(channel->revents() |
+                                     channel->deferredRevents());
+                channel->set_deferredRevents(0);
+            }
+        }
+        // 其余的排在这一轮的最前面（它们已经等了一轮了）
+        ChannelList ready;
+        ready.swap(deferredChannels_);
+        size_t n = 0;
+        for (Channel* channel : ready) {
+            if (channel->deferredRevents()) {
+                channel->set_revents(channel->deferredRevents());
+                channel->set_deferredRevents(0);
+                ready[n++] = channel;
+            }
+        }
+        ready.resize(n);
+        activeChannels_.insert(activeChannels_.begin(), ready.begin(),
+                               ready.end());
+    }
+
+    const size_t count = activeChannels_.size();
+    for (size_t i = 0; i < count; ++i) {
+        currentActiveChannel_ = activeChannels_[i];
+        // Poller监听哪些channel发生事件了，然后上报给EventLoop，通知channel处理相应的事件
+        currentActiveChannel_->handleEvent(pollReturnTime_);
+        // 至少处理一个，超出预算后剩下的留到下一轮（LT/ET都不会丢事件）
+        if (eventTimeBudget_ > 0 && i + 1 < count &&
+            Timestamp::now().microSecondsSinceEpoch() -
+                    pollReturnTime_.microSecondsSinceEpoch() >=
+                eventTimeBudget_) {
+            for (size_t j = i + 1; j < count; ++j) {
+                Channel* channel = activeChannels_[j];
+                channel->set_deferredRevents(channel->revents());
+                deferredChannels_.push_back(channel);
+            }
+            deferredEvents_.fetch_add(count - i - 1, std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
 // 退出事件循环  1.loop在自己的线程中调用quit  2.在非loop的线程中，调用loop的quit
 /**
  *              mainLoop
@@ -128,16 +197,14 @@ void EventLoop::runInLoop(Functor cb) {
     if (isInLoopThread()) {  // 在当前的loop线程中，执行cb
         cb();
     } else {  // 在非当前线程中执行cb，就需要唤醒loop所在线程，执行cb
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 // 把cb放入队列中，唤醒loop所在的线程，执行cb
 void EventLoop::queueInLoop(Functor cb) {
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        // emplace_back减少拷贝开销
-        pendingFunctors_.emplace_back(std::move(cb));
-    }
+    // 无锁入队，生产者之间不再争抢同一把mutex
+    pendingFunctors_.push(std::move(cb));
+    numPendingFunctors_.fetch_add(1, std::memory_order_relaxed);
 
     // 唤醒相应的线程，需要执行上面回调操作的loop的线程了
     // ||callingPendingFunctors_的意思是：当前loop正在执行回调，但是loop又有了新的回调，继续唤醒执行新的回调
@@ -148,7 +215,15 @@ void EventLoop::queueInLoop(Functor cb) {
 
 // 用来唤醒loop所在的线程的，向wakeupfd_写一个数据（8 bytes）
 // wakeupChannel就发生读事件，当前loop线程就会被唤醒
+// 上一次的唤醒loop还没有处理（handleRead还没读走eventfd）时，再写一次毫无意义，
+// 只有从false变成true的那一次调用才真正write
 void EventLoop::wakeup() {
+    if (wakeupPending_.exchange(true, std::memory_order_acq_rel)) {
+        wakeupsSuppressed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    wakeupsIssued_.fetch_add(1, std::memory_order_relaxed);
+
     uint64_t one = 1;
     ssize_t n = write(wakeupFd_, &one, sizeof one);
     if (n != sizeof one) {
@@ -166,6 +241,16 @@ void EventLoop::updateChannel(Channel* channel) {
 
 void EventLoop::removeChannel(Channel* channel) {
     assert(channel->ownerLoop() == this);
+    // 被推迟的channel要从列表里去掉，它可能马上就被析构了
+    if (channel->deferredRevents()) {
+        channel->set_deferredRevents(0);
+        for (size_t i = 0; i < deferredChannels_.size(); ++i) {
+            if (deferredChannels_[i] == channel) {
+                deferredChannels_.erase(deferredChannels_.begin() + i);
+                break;
+            }
+        }
+    }
     poller_->removeChannel(channel);
 }
 
@@ -180,26 +265,21 @@ void EventLoop::handleRead() {
     if (n != sizeof(one)) {
         LOG_ERROR("EventLoop::handleRead() reads %lu bytes \n", n);
     }
+    // 必须在doPendingFunctors之前清掉标志：之后再入队的回调会重新write唤醒，
+    // 之前入队的回调一定能被接下来的doPendingFunctors看到
+    wakeupPending_.exchange(false, std::memory_order_acq_rel);
 }
 
 // 执行回调
 void EventLoop::doPendingFunctors() {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        // 使得EventLoop::queueInLoop中往 pendingFunctors_ 加入回调不用等待这一批回调执行完就可加入，提高并发性
-        // 相当于把pendingFunctors_解放了
-        // 还没执行完当前这个loop执行的回调，
-        // 也不妨碍mainloop向当前这个loop写回调
-        // 因为pendingFunctors_被释放了
-        functors.swap(pendingFunctors_);
-    }
-
-    for (const Functor& functor : functors) {
+    // 只执行本轮开始前已经入队的回调，执行过程中新加入的回调留到下一轮，
+    // 和原来 swap 出一批再执行的语义一致（queueInLoop 会负责唤醒）
+    size_t n = pendingFunctors_.consume([](Functor& functor) {
         functor();  // 执行当前loop需要执行的回调操作
-    }
+    });
+    numPendingFunctors_.fetch_sub(n, std::memory_order_relaxed);
 
     callingPendingFunctors_ = false;
 }
@@ -7,25 +7,31 @@
 #include <mutex>
 #include <vector>
 
+#include "BufferPool.h"
 #include "CurrentThread.h"
+#include "LatencyHistogram.h"
+#include "Poller.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
 #include "TimerId.h"
+#include "TimerQueue.h"
 #include "Callbacks.h"
+#include "MpscQueue.h"
 
 namespace mynetlib
 {
 
 class Channel;
-class Poller;
-class TimerQueue;
 
 // 时间循环类  主要包含了两个大模块 Channel   Poller（epoll的抽象）
 class EventLoop : noncopyable {
 public:
     using Functor = std::function<void()>;
 
-    EventLoop();
+    // pollerType选择底层的IO复用实现，默认由环境变量决定（见Poller::newDefaultPoller）
+    // timerQueueType选择定时器队列的实现（见TimerQueue::newDefaultTimerQueue）
+    explicit EventLoop(Poller::Type pollerType = Poller::kDefault,
+                       TimerQueue::Type timerQueueType = TimerQueue::kDefault);
     ~EventLoop();
 
     // 开启事件循环
@@ -34,6 +40,8 @@ public:
     void quit();
 
     Timestamp pollReturnTime() const { return pollReturnTime_; }
+    // poller返回的次数（loop循环的次数）
+    int64_t iteration() const { return iteration_; }
 
     // 在当前loop中执行cb
     void runInLoop(Functor cb);
@@ -43,6 +51,34 @@ public:
     // 用来唤醒loop所在的线程的
     void wakeup();
 
+    // 实际写了eventfd的唤醒次数 / 因为已有未处理的唤醒而被合并掉的次数
+    uint64_t wakeupsIssued() const { return wakeupsIssued_.load(std::memory_order_relaxed); }
+    uint64_t wakeupsSuppressed() const { return wakeupsSuppressed_.load(std::memory_order_relaxed); }
+
+    // 一轮循环里处理IO事件最多用多少微秒，用完后剩下的channel推迟到下一轮，
+    // 先执行pendingFunctors，再和定时器、新的IO事件一起处理；0表示不限制（默认）
+    // 在loop线程中或者loop()开始前调用
+    void setEventTimeBudget(int64_t microseconds) { eventTimeBudget_ = microseconds; }
+    // 因为时间预算被推迟到下一轮处理的channel事件数
+    int64_t deferredEvents() const { return deferredEvents_.load(std::memory_order_relaxed); }
+
+    // 统计每一轮的延迟直方图（每轮多几次取时间的开销），默认关闭
+    void enableLatencyStats(bool on) { latencyStats_ = on; }
+    // 每一轮处理IO事件的耗时，也就是pendingFunctors被推迟的时间
+    const LatencyHistogram& eventHandlingLatency() const { return eventHandlingLatency_; }
+    // 每一轮执行pendingFunctors的耗时
+    const LatencyHistogram& pendingFunctorsLatency() const { return pendingFunctorsLatency_; }
+
+    // 负载统计，任意线程读，EventLoopThreadPool选择loop时用
+    // 队列里还没执行的回调个数
+    int64_t numPendingFunctors() const { return numPendingFunctors_.load(std::memory_order_relaxed); }
+    // 这个loop上的连接数，TcpServer把新连接分给这个loop时加一、移除连接时减一
+    int numConnections() const { return numConnections_.load(std::memory_order_relaxed); }
+    void adjustNumConnections(int delta) { numConnections_.fetch_add(delta, std::memory_order_relaxed); }
+
+    // 这个loop线程的缓冲区内存池，可以在任意线程读取它的统计（bytesInUse等）
+    BufferPool* bufferPool() const { return bufferPool_; }
+
     // EventLoop的方法 =》 Poller的方法
     void updateChannel(Channel* channel);
     void removeChannel(Channel* channel);
@@ -71,6 +107,8 @@ public:
 private:
     void handleRead();  // wake up  通过给wakeupfd上写入数据，唤醒ioLoop
     void doPendingFunctors();  // 执行回调
+    // 依次处理activeChannels_，超出时间预算时把剩下的推迟到下一轮
+    void handleActiveChannels();
 
     using ChannelList = std::vector<Channel*>;
 
@@ -83,6 +121,7 @@ private:
     const pid_t threadId_; 
 
     Timestamp pollReturnTime_;  // poller返回发生事件的channels的时间点
+    int64_t iteration_;
     std::unique_ptr<Poller> poller_;
     std::unique_ptr<TimerQueue> timerQueue_;
 
@@ -90,16 +129,31 @@ private:
     int wakeupFd_;  // 主要作用，当mainLoop获取一个新用户的channel，通过轮询算法选择一个subloop，通过该成员唤醒subloop处理channel
     // 别的线程唤醒本loop线程使用的Channel
     std::unique_ptr<Channel> wakeupChannel_;
+    // 已经写过eventfd但loop还没读走，这期间的wakeup只需要置位，不用再write
+    std::atomic_bool wakeupPending_;
+    std::atomic_uint64_t wakeupsIssued_;
+    std::atomic_uint64_t wakeupsSuppressed_;
 
     std::any context_;
 
     ChannelList activeChannels_;
     Channel* currentActiveChannel_;
+    BufferPool* bufferPool_;
+
+    int64_t eventTimeBudget_;  // 微秒，0表示不限制
+    ChannelList deferredChannels_;  // 上一轮没来得及处理的channel
+    std::atomic<int64_t> deferredEvents_;
+    bool latencyStats_;
+    LatencyHistogram eventHandlingLatency_;
+    LatencyHistogram pendingFunctorsLatency_;
 
     std::atomic_bool
         callingPendingFunctors_;  // 标识当前loop是否有需要执行的回调操作
-    std::vector<Functor> pendingFunctors_;  // 存储loop需要执行的所有的回调操作
-    std::mutex mutex_;  // 互斥锁，用来保护上面vector容器的线程安全操作（保护 pendingFunctors_ 线程安全操作）
+    // 存储loop需要执行的所有的回调操作
+    // 多个线程往里投递，只有loop线程自己取出执行，用无锁的MPSC队列代替 vector + mutex
+    MpscQueue<Functor> pendingFunctors_;
+    std::atomic<int64_t> numPendingFunctors_;
+    std::atomic_int numConnections_;
 };
 
 
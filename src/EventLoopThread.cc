@@ -1,18 +1,26 @@
 #include "EventLoopThread.h"
+#include "CpuAffinity.h"
 #include "EventLoop.h"
+#include "Logger.h"
 
 
 namespace mynetlib
 {
 // 底下几个都是默认构造
 EventLoopThread::EventLoopThread(const ThreadInitCallback& cb,
-                                 const std::string& name)
+                                 const std::string& name,
+                                 Poller::Type pollerType,
+                                 TimerQueue::Type timerQueueType,
+                                 int cpu)
     : loop_(nullptr),
       exiting_(false),
       thread_(std::bind(&EventLoopThread::threadFunc, this), name),
       mutex_(),
       cond_(),
-      callback_(cb) {}
+      callback_(cb),
+      pollerType_(pollerType),
+      timerQueueType_(timerQueueType),
+      cpu_(cpu) {}
 
 EventLoopThread::~EventLoopThread() {
     exiting_ = true;
@@ -41,9 +49,19 @@ EventLoop* EventLoopThread::startLoop() {
 // 下面这个方法，是在单独的新线程里面运行的，即thread_.start()内的func()
 // 这才是真真正正执行的线程
 void EventLoopThread::threadFunc() {
+    // 要在创建EventLoop之前绑核：loop、poller、BufferPool以及之后的缓冲区都在这之后分配，
+    // 落在这个CPU所在的NUMA节点上
+    if (cpu_ >= 0 && CpuAffinity::pinCurrentThread(cpu_)) {
+        int node = CpuAffinity::nodeOfCpu(cpu_);
+        if (node >= 0) {
+            CpuAffinity::preferNode(node);
+        }
+        LOG_INFO("EventLoopThread pinned to cpu %d node %d \n", cpu_, node);
+    }
+
     // 创建了一个独立的eventloop，和上面的线程是一一对应的，one loop per thread
     // 栈上分配
-    EventLoop loop;  
+    EventLoop loop(pollerType_, timerQueueType_);
 
     if (callback_) {
         callback_(&loop);
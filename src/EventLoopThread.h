@@ -1,6 +1,8 @@
 #pragma once
 
 #include "noncopyable.h"
+#include "Poller.h"
+#include "TimerQueue.h"
 #include "Thread.h"
 
 #include <functional>
@@ -20,7 +22,10 @@ public:
 
     // 这个类对象是由 EventLoopThread::start() 创建
     EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback(), 
-        const std::string &name = std::string());
+        const std::string &name = std::string(),
+        Poller::Type pollerType = Poller::kDefault,
+        TimerQueue::Type timerQueueType = TimerQueue::kDefault,
+        int cpu = -1);
     ~EventLoopThread();
 
     EventLoop* startLoop();
@@ -35,5 +40,11 @@ private:
     std::condition_variable cond_;
     // 用于线程初始化的回调
     ThreadInitCallback callback_;
+    // 线程里创建的EventLoop使用的IO复用实现
+    Poller::Type pollerType_;
+    // 线程里创建的EventLoop使用的定时器队列实现
+    TimerQueue::Type timerQueueType_;
+    // 线程绑定的CPU，-1表示不绑定
+    int cpu_;
 };
 }
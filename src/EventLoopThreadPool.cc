@@ -1,6 +1,11 @@
 #include "EventLoopThreadPool.h"
+#include "EventLoop.h"
 #include "EventLoopThread.h"
+#include "InetAddress.h"
+#include "Logger.h"
 
+#include <stdint.h>
+#include <algorithm>
 #include <memory>
 
 namespace mynetlib {
@@ -10,7 +15,10 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop,
       name_(nameArg),
       started_(false),
       numThreads_(0),
-      next_(0) {}
+      next_(0),
+      selection_(kRoundRobin),
+      pollerType_(Poller::kDefault),
+      timerQueueType_(TimerQueue::kDefault) {}
 
 EventLoopThreadPool::~EventLoopThreadPool() {}
 
@@ -22,12 +30,14 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb) {
     for (int i = 0; i < numThreads_; ++i) {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
-        EventLoopThread* t = new EventLoopThread(cb, buf);
+        int cpu = cpus_.empty() ? -1 : cpus_[i % cpus_.size()];
+        EventLoopThread* t = new EventLoopThread(cb, buf, pollerType_, timerQueueType_, cpu);
         // 根据开启的线程数开启相应的线程，
         threads_.push_back(std::unique_ptr<EventLoopThread>(t));
         // 执行startLoop函数，返回loop指针，（没执行threadFunc灰调函数的话，线程会阻塞）
         loops_.push_back(
             t->startLoop());  // 底层创建线程，绑定一个新的EventLoop，并返回该loop的地址
+        loopCpus_.push_back(cpu);
     }
 
     // 整个服务端只有一个线程，运行这baseloop
@@ -52,6 +62,90 @@ EventLoop* EventLoopThreadPool::getNextLoop() {
     return loop;
 }
 
+EventLoop* EventLoopThreadPool::getNextLoop(const InetAddress& peerAddr) {
+    if (loops_.empty()) {
+        return baseLoop_;
+    }
+    if (selector_) {
+        EventLoop* loop = selector_(loops_, peerAddr);
+        if (std::find(loops_.begin(), loops_.end(), loop) != loops_.end()) {
+            return loop;
+        }
+        // 选了不在loops里的loop（比如baseLoop），退回轮询
+        LOG_ERROR("EventLoopThreadPool::getNextLoop selector returned loop %p "
+                  "not in the pool, fall back to round robin \n", loop);
+        return getNextLoop();
+    }
+    const size_t n = loops_.size();
+    switch (selection_) {
+        case kLeastConnections:
+        case kLeastPendingFunctors: {
+            // 从轮询位置开始扫描，负载相同时依次分给不同的loop，而不是总选第一个
+            size_t start = next_;
+            next_ = (next_ + 1) % n;
+            EventLoop* best = nullptr;
+            int64_t bestLoad = 0;
+            for (size_t i = 0; i < n; ++i) {
+                EventLoop* loop = loops_[(start + i) % n];
+                int64_t load = selection_ == kLeastConnections
+                                   ? loop->numConnections()
+                                   : loop->numPendingFunctors();
+                if (best == nullptr || load < bestLoad) {
+                    best = loop;
+                    bestLoad = load;
+                }
+            }
+            return best;
+        }
+        case kHashPeerAddress:
+            // 只按IP，不按端口：同一台客户端的所有连接在同一个loop上
+            return getLoopForHash(peerAddr.getSockAddr()->sin_addr.s_addr);
+        case kPowerOfTwoChoices: {
+            if (n == 1) {
+                return loops_[0];
+            }
+            size_t a = random_() % n;
+            size_t b = (a + 1 + random_() % (n - 1)) % n;
+            return loops_[b]->numConnections() < loops_[a]->numConnections()
+                       ? loops_[b]
+                       : loops_[a];
+        }
+        case kRoundRobin:
+        default:
+            return getNextLoop();
+    }
+}
+
+EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode) {
+    if (loops_.empty()) {
+        return baseLoop_;
+    }
+    // 先打散一下，IP这种低位很有规律的值直接取模会扎堆
+    uint64_t h = static_cast<uint64_t>(hashCode) * 0x9E3779B97F4A7C15ULL;
+    return loops_[(h >> 32) % loops_.size()];
+}
+
+EventLoop* EventLoopThreadPool::getLoopForCpu(int cpu) const {
+    if (cpu < 0) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        if (loopCpus_[i] == cpu) {
+            return loops_[i];
+        }
+    }
+    return nullptr;
+}
+
+int EventLoopThreadPool::cpuOfLoop(EventLoop* loop) const {
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        if (loops_[i] == loop) {
+            return loopCpus_[i];
+        }
+    }
+    return -1;
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops() {
     if (loops_.empty()) {  // 没有自定义线程数就只有一个mainLoop
         return std::vector<EventLoop*>(1, baseLoop_);
@@ -1,19 +1,37 @@
 #pragma once
 #include "noncopyable.h"
+#include "Poller.h"
+#include "TimerQueue.h"
 
+#include <stddef.h>
 #include <functional>
+#include <memory>
+#include <random>
 #include <string>
 #include <vector>
-#include <memory>
 
 namespace mynetlib
 {
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool:noncopyable{
 public:
     using ThreadInitCallback=std::function<void(EventLoop*)>;
+    // 自定义的loop选择：从loops里给peerAddr的新连接挑一个
+    // 必须返回loops中的一个，返回其他loop（包括nullptr、baseLoop）时记一条错误日志并退回轮询
+    using LoopSelector=std::function<EventLoop*(const std::vector<EventLoop*>& loops,
+                                                const InetAddress& peerAddr)>;
+
+    // 新连接分配给哪个subloop
+    enum LoopSelection {
+        kRoundRobin,            // 轮询（默认）
+        kLeastConnections,      // 连接数最少的
+        kLeastPendingFunctors,  // 待执行回调最少的，反映loop当前忙不忙
+        kHashPeerAddress,       // 按对端IP哈希，同一个客户端总是落在同一个loop上
+        kPowerOfTwoChoices,     // 随机挑两个，取连接数少的那个，不用每次扫描所有loop
+    };
 
     // baseLoop事件循环
     EventLoopThreadPool(EventLoop *baseLoop, const std::string &nameArg);
@@ -23,11 +41,42 @@ public:
         numThreads_=numThreads;
     }
 
+    // subloop使用的IO复用实现，需要在start之前设置
+    void setPollerType(Poller::Type pollerType){
+        pollerType_=pollerType;
+    }
+
+    // subloop使用的定时器队列实现，需要在start之前设置
+    void setTimerQueueType(TimerQueue::Type timerQueueType){
+        timerQueueType_=timerQueueType;
+    }
+
+    void setLoopSelection(LoopSelection selection){
+        selection_=selection;
+    }
+    // 第i个loop线程绑定到cpus[i % cpus.size()]上，内存优先从该CPU的NUMA节点分配，空表示不绑定（默认）
+    // 需要在start之前设置
+    void setCpuAffinity(const std::vector<int>& cpus){
+        cpus_=cpus;
+    }
+    // 设置之后优先于setLoopSelection
+    void setLoopSelector(const LoopSelector& selector){
+        selector_=selector;
+    }
+
     // ???谁来调用传入cb
     void start(const ThreadInitCallback &cb=ThreadInitCallback());
 
     // 如果工作在多线程中，baseLoop_默认以轮询的方式分配channel给subloop
     EventLoop* getNextLoop();
+    // 按setLoopSelection/setLoopSelector的策略给peerAddr的新连接选一个loop
+    EventLoop* getNextLoop(const InetAddress& peerAddr);
+    // 同一个hashCode总是得到同一个loop
+    EventLoop* getLoopForHash(size_t hashCode);
+    // 绑定在cpu上的loop，没有时返回nullptr
+    EventLoop* getLoopForCpu(int cpu) const;
+    // loop绑定的CPU，没有绑定时返回-1
+    int cpuOfLoop(EventLoop* loop) const;
 
     // 返回池里所有的loops
     std::vector<EventLoop*> getAllLoops();
@@ -41,11 +90,18 @@ private:
     bool started_;
     int numThreads_;
     int next_; //做下一个loop的下标用的，就是轮询用的小包；
+    LoopSelection selection_;
+    LoopSelector selector_;
+    std::minstd_rand random_;  // kPowerOfTwoChoices用，只在选择loop的线程里用
+    Poller::Type pollerType_;
+    TimerQueue::Type timerQueueType_;
     // 包含所有创建的事件的线程
     std::vector<std::unique_ptr<EventLoopThread>> threads_;
     // 包含事件线程里，所有EventLoop的指针
     // 通过调用EventLoopThread中startLoop()可以产生
     std::vector<EventLoop*> loops_;
+    std::vector<int> cpus_;
+    std::vector<int> loopCpus_;  // 和loops_一一对应，-1表示没有绑定
 
 
 };
@@ -0,0 +1,95 @@
+#include "IdleReaper.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TcpConnection.h"
+
+#include <math.h>
+
+namespace mynetlib
+{
+
+IdleReaper::IdleReaper(EventLoop* loop, double idleSeconds)
+    : loop_(loop),
+      idleSeconds_(idleSeconds),
+      tickSeconds_(idleSeconds / kBuckets),
+      buckets_(kBuckets + 1),
+      current_(0),
+      reaped_(0),
+      tracked_(0)
+{
+}
+
+IdleReaper::~IdleReaper()
+{
+    // TcpServer析构时loop还活着（线程池在之后才析构），取消周期定时器
+    loop_->cancel(timerId_);
+}
+
+void IdleReaper::start()
+{
+    // 定时器里只持有weak_ptr，TcpServer析构之后定时器即使再触发一次也不会访问已经释放的对象
+    std::weak_ptr<IdleReaper> weakSelf(shared_from_this());
+    timerId_ = loop_->runEvery(tickSeconds_, [weakSelf] {
+        std::shared_ptr<IdleReaper> self = weakSelf.lock();
+        if (self)
+        {
+            self->onTick();
+        }
+    });
+}
+
+void IdleReaper::add(const TcpConnectionPtr& conn)
+{
+    // 新连接刚刚活跃过，放到一整个超时周期之后检查
+    buckets_[(current_ + kBuckets) % buckets_.size()].push_back(conn);
+    tracked_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IdleReaper::onTick()
+{
+    current_ = (current_ + 1) % buckets_.size();
+    expiring_.swap(buckets_[current_]);
+
+    Timestamp now = loop_->pollReturnTime();
+    int64_t idleUs = static_cast<int64_t>(idleSeconds_ * Timestamp::kMicroSecondsPerSecond);
+    for (const std::weak_ptr<TcpConnection>& weakConn : expiring_)
+    {
+        TcpConnectionPtr conn = weakConn.lock();
+        if (!conn || !conn->connected())
+        {
+            // 连接已经关闭了
+            tracked_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        int64_t idle = now.microSecondsSinceEpoch() -
+                       conn->lastActive().microSecondsSinceEpoch();
+        if (idle >= idleUs)
+        {
+            LOG_INFO("IdleReaper close idle connection %s, idle %.1fs \n",
+                     conn->name().c_str(),
+                     static_cast<double>(idle) / Timestamp::kMicroSecondsPerSecond);
+            conn->forceClose();
+            reaped_.fetch_add(1, std::memory_order_relaxed);
+            tracked_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            // 期间活跃过，按剩余的空闲时间放到后面的桶里
+            double remaining = static_cast<double>(idleUs - idle) / Timestamp::kMicroSecondsPerSecond;
+            int ticks = static_cast<int>(ceil(remaining / tickSeconds_));
+            if (ticks < 1)
+            {
+                ticks = 1;
+            }
+            else if (ticks > kBuckets)
+            {
+                ticks = kBuckets;
+            }
+            buckets_[(current_ + ticks) % buckets_.size()].push_back(weakConn);
+        }
+    }
+    expiring_.clear();
+}
+
+}
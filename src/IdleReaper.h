@@ -0,0 +1,66 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "Timestamp.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace mynetlib
+{
+
+class EventLoop;
+
+/**
+ * 关闭空闲连接（每个loop一个，由TcpServer创建）
+ *
+ * 不给每个连接一个定时器：连接收发数据时只更新TcpConnection::lastActive()，
+ * 这里用一圈桶（kBuckets+1个）装连接，整个loop只有一个周期定时器，每个tick检查一个桶：
+ *   空闲超过idleSeconds的连接 forceClose
+ *   期间有过收发的，按最后活跃时间挪到后面对应的桶里（惰性的，每个超时周期最多挪一次）
+ * 连接实际被关闭的时间在 idleSeconds ~ idleSeconds*(1+1/kBuckets) 之间
+ *
+ * 除了统计数字，所有方法都只在loop线程中调用
+ */
+class IdleReaper : noncopyable,
+                   public std::enable_shared_from_this<IdleReaper>
+{
+public:
+    IdleReaper(EventLoop* loop, double idleSeconds);
+    ~IdleReaper();
+
+    // 开启周期定时器，需要在shared_ptr管理之后调用
+    void start();
+
+    // 登记一个新建立的连接
+    void add(const TcpConnectionPtr& conn);
+
+    // 因为空闲被关闭的连接个数（任意线程）
+    int64_t reaped() const { return reaped_.load(std::memory_order_relaxed); }
+    // 当前登记的连接个数（包括已经断开、还没被清理出桶的，任意线程）
+    int64_t tracked() const { return tracked_.load(std::memory_order_relaxed); }
+
+private:
+    static const int kBuckets = 8;
+
+    using Bucket = std::vector<std::weak_ptr<TcpConnection>>;
+
+    void onTick();
+
+    EventLoop* loop_;
+    const double idleSeconds_;
+    const double tickSeconds_;
+    TimerId timerId_;
+
+    std::vector<Bucket> buckets_;
+    size_t current_;  // 当前tick要检查的桶
+    Bucket expiring_;  // 处理中的桶，反复使用避免分配
+
+    std::atomic<int64_t> reaped_;
+    std::atomic<int64_t> tracked_;
+};
+
+}
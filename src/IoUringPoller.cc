@@ -0,0 +1,344 @@
+#include "IoUringPoller.h"
+#include "Channel.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#define MYNETLIB_HAVE_IO_URING 1
+#else
+#define MYNETLIB_HAVE_IO_URING 0
+#endif
+
+namespace mynetlib
+{
+
+// 和EPollPoller一样，用index_表示channel在poller中的状态
+const int kNew = -1;
+const int kAdded = 1;
+const int kDeleted = 2;
+
+#if MYNETLIB_HAVE_IO_URING
+
+// 取消poll请求自己的完成事件用这个user_data，直接忽略
+const uint64_t kCancelUserData = 0;
+
+static inline uint64_t makeUserData(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+static int sysSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sysEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                    unsigned flags, void* arg, size_t argSize) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                      minComplete, flags, arg, argSize));
+}
+
+bool IoUringPoller::supported() {
+    static const bool ok = [] {
+        io_uring_params params;
+        memset(&params, 0, sizeof params);
+        int fd = sysSetup(4, &params);
+        if (fd < 0) {
+            return false;
+        }
+        ::close(fd);
+        // 需要带超时的io_uring_enter，以及CQ满时不丢事件
+        return (params.features & IORING_FEAT_EXT_ARG) &&
+               (params.features & IORING_FEAT_NODROP);
+    }();
+    return ok;
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop),
+      ringFd_(-1),
+      sqRing_(nullptr),
+      sqRingSize_(0),
+      sqes_(nullptr),
+      sqesSize_(0),
+      sqLocalTail_(0),
+      cqRing_(nullptr),
+      cqRingSize_(0) {
+    setupRing();
+}
+
+IoUringPoller::~IoUringPoller() {
+    if (sqes_ != nullptr) {
+        ::munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != nullptr) {
+        ::munmap(sqRing_, sqRingSize_);
+    }
+    ::close(ringFd_);
+}
+
+void IoUringPoller::setupRing() {
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+    ringFd_ = sysSetup(kRingEntries, &params);
+    if (ringFd_ < 0) {
+        LOG_FATAL("io_uring_setup error:%d \n", errno);
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // 新内核SQ和CQ共用一块映射
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        LOG_FATAL("io_uring mmap sq ring error:%d \n", errno);
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            LOG_FATAL("io_uring mmap cq ring error:%d \n", errno);
+        }
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(
+        ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+        LOG_FATAL("io_uring mmap sqes error:%d \n", errno);
+    }
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqRingMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+    sqLocalTail_ = *sqTail_;
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqRingMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+int IoUringPoller::enter(bool wait, int waitMs) {
+    unsigned toSubmit =
+        sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    __kernel_timespec ts;
+    memset(&arg, 0, sizeof arg);
+    if (wait) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (waitMs >= 0) {
+            ts.tv_sec = waitMs / 1000;
+            ts.tv_nsec = (waitMs % 1000) * 1000 * 1000;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+    return sysEnter(ringFd_, toSubmit, wait ? 1 : 0, flags,
+                    wait ? &arg : nullptr, wait ? sizeof arg : 0);
+}
+
+io_uring_sqe* IoUringPoller::getSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqLocalTail_ - head >= sqEntries_) {
+        // SQ满了，先把已有的请求提交给内核
+        if (enter(false, 0) < 0) {
+            LOG_FATAL("io_uring_enter submit error:%d \n", errno);
+        }
+    }
+
+    unsigned index = sqLocalTail_ & *sqRingMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof *sqe);
+    sqArray_[index] = index;
+    ++sqLocalTail_;
+    // 调用者填好sqe之后再发布sqTail_
+    return sqe;
+}
+
+IoUringPoller::PollState& IoUringPoller::stateOf(int fd) {
+    if (static_cast<size_t>(fd) >= states_.size()) {
+        states_.resize(fd + 1);
+    }
+    return states_[fd];
+}
+
+void IoUringPoller::armPoll(Channel* channel) {
+    int fd = channel->fd();
+    PollState& state = stateOf(fd);
+    state.channel = channel;
+    state.armed = true;
+    ++state.generation;
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    // one-shot poll每轮重新挂上本来就只上报一次，EPOLLET对它没有意义，去掉
+    sqe->poll32_events = static_cast<uint32_t>(channel->events() & ~EPOLLET);
+    sqe->user_data = makeUserData(fd, state.generation);
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+}
+
+void IoUringPoller::cancelPoll(int fd) {
+    PollState& state = stateOf(fd);
+    if (!state.armed) {
+        return;
+    }
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, state.generation);
+    sqe->user_data = kCancelUserData;
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+
+    // 被取消的请求还会产生一个-ECANCELED的完成事件，generation变了之后会被忽略
+    state.armed = false;
+    ++state.generation;
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels) {
+    LOG_TRACE("func=%s => fd total count:%lu \n", __FUNCTION__,
+              channels_.size());
+
+    // 上一轮上报过事件的channel重新挂上poll（LT语义）
+    for (int fd : rearm_) {
+        PollState& state = stateOf(fd);
+        Channel* channel = state.channel;
+        if (!state.armed && channel != nullptr && channel->index() == kAdded &&
+            !channel->isNoneEvent()) {
+            armPoll(channel);
+        }
+    }
+    rearm_.clear();
+
+    // 提交所有积攒的请求，同时等待完成事件，只有这一次系统调用
+    int ret = enter(true, timeoutMs);
+    int saveErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if (ret < 0 && saveErrno != ETIME && saveErrno != EINTR &&
+        saveErrno != EAGAIN && saveErrno != EBUSY) {
+        errno = saveErrno;
+        LOG_ERROR("IoUringPoller::poll() err:%d \n", saveErrno);
+    }
+
+    fillActiveChannels(activeChannels);
+    return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels) {
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    unsigned mask = *cqRingMask_;
+
+    for (; head != tail; ++head) {
+        const io_uring_cqe* cqe = &cqes_[head & mask];
+        if (cqe->user_data == kCancelUserData) {
+            continue;
+        }
+        int fd = static_cast<int>(cqe->user_data & 0xffffffff);
+        uint32_t generation = static_cast<uint32_t>(cqe->user_data >> 32);
+        if (static_cast<size_t>(fd) >= states_.size()) {
+            continue;
+        }
+        PollState& state = states_[fd];
+        // 已经被取消或者重新挂过的请求
+        if (!state.armed || state.generation != generation ||
+            state.channel == nullptr) {
+            continue;
+        }
+        state.armed = false;
+        rearm_.push_back(fd);
+
+        if (cqe->res == -ECANCELED) {
+            continue;
+        }
+        int revents = cqe->res < 0 ? static_cast<int>(EPOLLERR) : cqe->res;
+        state.channel->set_revents(revents);
+        activeChannels->push_back(state.channel);
+    }
+    __atomic_store_n(cqHead_, tail, __ATOMIC_RELEASE);
+
+    if (!activeChannels->empty()) {
+        LOG_TRACE("%lu events happened \n", activeChannels->size());
+    }
+}
+
+void IoUringPoller::updateChannel(Channel* channel) {
+    const int index = channel->index();
+    const int fd = channel->fd();
+    LOG_TRACE("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__, fd,
+              channel->events(), index);
+
+    if (index == kNew || index == kDeleted) {
+        if (index == kNew) {
+            channels_[fd] = channel;
+        }
+        channel->set_index(kAdded);
+        cancelPoll(fd);
+        armPoll(channel);
+    } else {
+        // 感兴趣的事件变了，取消旧的poll再挂上新的，都只是往SQ里放请求
+        cancelPoll(fd);
+        if (channel->isNoneEvent()) {
+            channel->set_index(kDeleted);
+        } else {
+            armPoll(channel);
+        }
+    }
+}
+
+void IoUringPoller::removeChannel(Channel* channel) {
+    int fd = channel->fd();
+    channels_.erase(fd);
+
+    LOG_TRACE("func=%s => fd=%d\n", __FUNCTION__, fd);
+
+    int index = channel->index();
+    assert(index == kAdded || index == kDeleted);
+    cancelPoll(fd);
+    PollState& state = stateOf(fd);
+    state.channel = nullptr;
+    channel->set_index(kNew);
+}
+
+#else  // !MYNETLIB_HAVE_IO_URING
+
+bool IoUringPoller::supported() { return false; }
+
+IoUringPoller::IoUringPoller(EventLoop* loop) : Poller(loop), ringFd_(-1) {
+    LOG_FATAL("io_uring is not available on this platform \n");
+}
+
+IoUringPoller::~IoUringPoller() {}
+
+Timestamp IoUringPoller::poll(int, ChannelList*) { return Timestamp::now(); }
+void IoUringPoller::updateChannel(Channel*) {}
+void IoUringPoller::removeChannel(Channel*) {}
+
+#endif
+
+}
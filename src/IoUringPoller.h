@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Poller.h"
+#include "Timestamp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace mynetlib
+{
+
+class Channel;
+
+/**
+ * 基于io_uring的IO复用（直接使用系统调用，不依赖liburing）
+ *
+ * 每个channel对应一个IORING_OP_POLL_ADD请求，epoll_ctl的 add/mod/del
+ * 变成往SQ里放请求，和等待事件一起在一次io_uring_enter里提交，省掉了epoll_ctl的系统调用
+ *
+ * 用的是one-shot poll：事件上报之后在下一次poll()里重新挂上，
+ * 挂上时内核会检查当前的就绪状态，这样得到的是和EPollPoller一样的LT语义
+ * （multishot poll只在有新的唤醒时才上报，TcpConnection一次没读完/写完就会卡住）
+ */
+class IoUringPoller : public Poller {
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+    // 当前内核（以及编译环境）是否支持本实现需要的io_uring特性
+    static bool supported();
+
+private:
+    // SQ的大小，CQ默认是它的两倍
+    static const unsigned kRingEntries = 1024;
+
+    // 每个fd上挂着的poll请求的状态
+    struct PollState {
+        PollState() : channel(nullptr), generation(0), armed(false) {}
+
+        Channel* channel;
+        // 每次挂上/取消都加一，和fd一起作为user_data，用来丢弃已经过期的完成事件
+        uint32_t generation;
+        bool armed;
+    };
+
+    void setupRing();
+    io_uring_sqe* getSqe();
+    // 提交SQ中所有未提交的请求，waitMs >= 0 时最多等待这么长时间的完成事件
+    int enter(bool wait, int waitMs);
+
+    void armPoll(Channel* channel);
+    void cancelPoll(int fd);
+    void fillActiveChannels(ChannelList* activeChannels);
+    PollState& stateOf(int fd);
+
+    int ringFd_;
+
+    // SQ ring
+    void* sqRing_;
+    size_t sqRingSize_;
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned* sqRingMask_;
+    unsigned* sqArray_;
+    unsigned sqEntries_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+    unsigned sqLocalTail_;
+
+    // CQ ring
+    void* cqRing_;
+    size_t cqRingSize_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned* cqRingMask_;
+    io_uring_cqe* cqes_;
+
+    std::vector<PollState> states_;  // 以fd为下标
+    std::vector<int> rearm_;  // 上一轮上报过事件、需要重新挂上poll的fd
+};
+
+}
@@ -0,0 +1,84 @@
+#include "LatencyHistogram.h"
+
+#include <stdio.h>
+
+namespace mynetlib
+{
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketOf(int64_t microseconds) {
+    if (microseconds <= 0) {
+        return 0;
+    }
+    // 64 - clz 就是二进制的位数：1 -> 1, 2~3 -> 2, 4~7 -> 3 ...
+    int bucket = 64 - __builtin_clzll(static_cast<uint64_t>(microseconds));
+    return bucket < kNumBuckets ? bucket : kNumBuckets - 1;
+}
+
+void LatencyHistogram::add(int64_t microseconds) {
+    std::atomic<int64_t>& bucket = buckets_[bucketOf(microseconds)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+    count_.store(count_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+    sum_.store(sum_.load(std::memory_order_relaxed) + microseconds,
+               std::memory_order_relaxed);
+    if (microseconds > max_.load(std::memory_order_relaxed)) {
+        max_.store(microseconds, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < kNumBuckets; ++i) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    int64_t n = count();
+    return n > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / n
+                 : 0.0;
+}
+
+int64_t LatencyHistogram::percentile(double p) const {
+    int64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    int64_t target = static_cast<int64_t>(p * n);
+    if (target >= n) {
+        target = n - 1;
+    }
+    int64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen > target) {
+            // 最后一个桶没有上界，用记录到的最大值
+            if (i == kNumBuckets - 1) {
+                return max();
+            }
+            // 桶i是[2^(i-1), 2^i)
+            return int64_t(1) << i;
+        }
+    }
+    return max();
+}
+
+std::string LatencyHistogram::toString() const {
+    char buf[160];
+    snprintf(buf, sizeof buf,
+             "count=%ld mean=%.1fus p50<=%ldus p90<=%ldus p99<=%ldus max=%ldus",
+             static_cast<long>(count()), mean(),
+             static_cast<long>(percentile(0.5)),
+             static_cast<long>(percentile(0.9)),
+             static_cast<long>(percentile(0.99)), static_cast<long>(max()));
+    return buf;
+}
+
+}
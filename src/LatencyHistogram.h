@@ -0,0 +1,45 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace mynetlib
+{
+
+/**
+ * 延迟直方图，按微秒的2的幂分桶：[0,1) [1,2) [2,4) [4,8) ...
+ * 只允许一个线程（loop线程）写，任意线程都可以读，读到的是近似值
+ * 写的时候只做relaxed的load/store，没有原子的读-改-写，不会比普通的计数贵多少
+ */
+class LatencyHistogram : noncopyable {
+public:
+    static const int kNumBuckets = 32;  // 最后一个桶收所有 >= 2^30us（约18分钟）的
+
+    LatencyHistogram();
+
+    // 只在写线程调用
+    void add(int64_t microseconds);
+    void reset();
+
+    int64_t count() const { return count_.load(std::memory_order_relaxed); }
+    int64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+    // p在[0, 1]之间，返回这个分位所在的桶的上界（微秒），落在最后一个桶时返回max()，没有数据时返回0
+    int64_t percentile(double p) const;
+
+    // "count=100 mean=12.3us p50<=16us p99<=128us max=97us"
+    std::string toString() const;
+
+private:
+    static int bucketOf(int64_t microseconds);
+
+    std::atomic<int64_t> buckets_[kNumBuckets];
+    std::atomic<int64_t> count_;
+    std::atomic<int64_t> sum_;
+    std::atomic<int64_t> max_;
+};
+
+}
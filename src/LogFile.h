@@ -0,0 +1,57 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
+#include <string>
+
+namespace mynetlib
+{
+
+/**
+ * 滚动的日志文件
+ *
+ * 文件名: basename.20240101-120000.hostname.pid.log
+ * 写满rollSize字节或者跨天时换一个新文件；每flushInterval秒flush一次
+ *
+ * 不是线程安全的，只在AsyncLogging的后台线程中使用
+ * （或者由调用方自己加锁）
+ */
+class LogFile : noncopyable {
+public:
+    LogFile(const std::string& basename,
+            off_t rollSize,
+            int flushInterval = 3,
+            int checkEveryN = 1024);
+    ~LogFile();
+
+    void append(const char* logline, int len);
+    void flush();
+    // 换一个新的日志文件，同一秒内不会重复换
+    bool rollFile();
+
+private:
+    static std::string getLogFileName(const std::string& basename, time_t* now);
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int flushInterval_;
+    // 每写这么多次才检查一次时间，避免每条日志都调用time()
+    const int checkEveryN_;
+
+    int count_;
+    time_t startOfPeriod_;  // 当前文件所在的那一天（对齐到0点）
+    time_t lastRoll_;
+    time_t lastFlush_;
+
+    FILE* fp_;
+    off_t writtenBytes_;
+    // 给FILE用的缓冲区，比默认的大，减少write系统调用
+    char buffer_[64 * 1024];
+
+    static const int kRollPerSeconds = 60 * 60 * 24;
+};
+
+}
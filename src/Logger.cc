@@ -1,41 +1,110 @@
 #include "Logger.h"
-#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "Timestamp.h"
 
 namespace mynetlib
 {
 
+std::atomic<int> Logger::minLogLevel_{-1};
+
+int Logger::initMinLogLevel() {
+    int level;
+    if (::getenv("MUDUO_LOG_TRACE")) {
+        level = TRACE;
+    } else if (::getenv("MUDUO_LOG_DEBUG")) {
+        level = DEBUG;
+    } else {
+#ifdef MUDEBUG
+        level = DEBUG;
+#else
+        level = INFO;
+#endif
+    }
+    // 其他线程可能已经初始化过或者调用了setMinLogLevel，以先写入的为准
+    int expected = -1;
+    if (!minLogLevel_.compare_exchange_strong(expected, level,
+                                              std::memory_order_relaxed)) {
+        level = expected;
+    }
+    return level;
+}
+
+static const char* const kLogLevelName[] = {
+    "[TRACE]", "[DEBUG]", "[INFO]", "[ERROR]", "[FATAL]",
+};
+
+// 默认的输出：写到stdout，不再每行都flush
+static void defaultOutput(const char* msg, int len) {
+    fwrite(msg, 1, len, stdout);
+}
+
+static void defaultFlush() {
+    fflush(stdout);
+}
+
+static Logger::OutputFunc g_output = defaultOutput;
+static Logger::FlushFunc g_flush = defaultFlush;
+
 // 获取日志唯一的实例对象
 Logger& Logger::instance() {
     static Logger logger;
     return logger;
 }
-// 设置日志级别
-void Logger::setLogLevel(int level) {
-    logLevel_ = level;
+
+void Logger::setOutput(OutputFunc out) {
+    g_output = out;
 }
 
-// 写日志  [级别信息] time : msg
-void Logger::log(std::string msg) {
-    switch (logLevel_) {
-        case INFO:
-            std::cout << "[INFO]";
-            break;
-        case ERROR:
-            std::cout << "[ERROR]";
-            break;
-        case FATAL:
-            std::cout << "[FATAL]";
-            break;
-        case DEBUG:
-            std::cout << "[DEBUG]";
-            break;
-        default:
-            break;
+void Logger::setFlush(FlushFunc flush) {
+    g_flush = flush;
+}
+
+// 每个线程缓存上一次格式化的 "年/月/日 时:分:秒"，同一秒内的日志只需要格式化微秒部分
+static __thread time_t t_lastSecond = -1;
+// 按6个int都取最长（各11个字符）加上分隔符来定大小，格式化不会被截断
+static __thread char t_time[6 * 11 + 5 + 1];
+
+// 把时间写到buf里 "2024/01/01 12:00:00.123456"，返回长度
+static int formatTime(char* buf, size_t size) {
+    int64_t microSecondsSinceEpoch = Timestamp::now().microSecondsSinceEpoch();
+    time_t seconds = static_cast<time_t>(microSecondsSinceEpoch /
+                                         Timestamp::kMicroSecondsPerSecond);
+    int microseconds = static_cast<int>(microSecondsSinceEpoch %
+                                        Timestamp::kMicroSecondsPerSecond);
+    if (seconds != t_lastSecond) {
+        t_lastSecond = seconds;
+        struct tm tm_time;
+        ::localtime_r(&seconds, &tm_time);
+        snprintf(t_time, sizeof t_time, "%4d/%02d/%02d %02d:%02d:%02d",
+                 tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                 tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
     }
+    return snprintf(buf, size, "%s.%06d", t_time, microseconds);
+}
 
+// 写日志  [级别信息] time : msg
+// 整行在栈上拼好之后一次交给输出函数，不同线程的日志不会交错
+void Logger::log(LogLevel level, const char* msg) {
+    char line[1280];
     // 打印时间 : msg
-    std::cout << Timestamp::now().toString() << " : " << msg << std::endl;
+    const char* levelName = kLogLevelName[level];
+    size_t levelLen = strlen(levelName);
+    memcpy(line, levelName, levelLen);
+    int len = static_cast<int>(levelLen);
+    len += formatTime(line + len, sizeof line - len);
+    memcpy(line + len, " : ", 3);
+    len += 3;
+    size_t msgLen = strnlen(msg, sizeof line - len - 1);
+    memcpy(line + len, msg, msgLen);
+    len += static_cast<int>(msgLen);
+    line[len++] = '\n';
+    g_output(line, len);
+    if (level == FATAL) {
+        // 马上就要退出了，把缓冲的日志都写出去
+        g_flush();
+    }
 }
 
-}
\ No newline at end of file
+}
@@ -1,82 +1,112 @@
 #pragma once
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
 #include <string>
 #include "noncopyable.h"
 
 namespace mynetlib
 {
+// 定义日志的级别 TRACE DEBUG INFO ERROR FATAL（毁灭性错误）
+// 按严重程度从低到高排列，低于门限的级别直接被过滤掉
+// 注意：和早先的 INFO=0 ERROR=1 FATAL=2 DEBUG=3 不同，按数值保存或比较级别的代码要跟着改
+enum LogLevel {
+    TRACE,  // 跟踪信息，每次poll、每个事件都会输出，只用于调试
+    DEBUG,  // 调试信息
+    INFO,   // 普通信息
+    ERROR,  // 错误信息
+    FATAL,  // core信息
+};
+
+// 编译期的日志门限，低于它的日志语句整个被编译器删掉（连参数都不会求值）
+// 定义了MUDEBUG时保留所有级别，否则TRACE和DEBUG不参与编译
+// 也可以用 -DMYNETLIB_MIN_LOG_LEVEL=N 直接指定
+#ifndef MYNETLIB_MIN_LOG_LEVEL
+#ifdef MUDEBUG
+#define MYNETLIB_MIN_LOG_LEVEL 0  // TRACE
+#else
+#define MYNETLIB_MIN_LOG_LEVEL 2  // INFO
+#endif
+#endif
+
 // 定义宏
 // LOG_INFO("%s %d", arg1, arg2)
 // 用宏来接受可变参, 定义大宏的时候都会用do while
-
+//
+// 先判断编译期门限（常量，不满足时整个分支被优化掉），再判断运行期门限（读一个整数），
+// 两个都满足才会去格式化、获取Logger实例，被过滤掉的日志没有任何开销
+//
 // 将可变参数__VA_ARGS__根据格式字符串logmsgFormat进行格式化，
 // 它的作用是在可变参数为空的情况下，省略前面的逗号。这样可以避免在宏展开时出现语法错误。
-#define LOG_INFO(logmsgFormat, ...)                       \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(INFO);                         \
-        char buf[1024] = {0};                             \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
-    } while (0)
-
-#define LOG_ERROR(logmsgFormat, ...)                      \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(ERROR);                        \
-        char buf[1024] = {0};                             \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
+#define LOG_WITH_LEVEL(level, logmsgFormat, ...)                     \
+    do {                                                             \
+        if ((level) >= MYNETLIB_MIN_LOG_LEVEL &&                     \
+            (level) >= Logger::minLogLevel()) {                      \
+            char buf[1024];                                          \
+            snprintf(buf, sizeof buf, logmsgFormat, ##__VA_ARGS__);  \
+            Logger::instance().log(level, buf);                      \
+        }                                                            \
     } while (0)
 
-#define LOG_FATAL(logmsgFormat, ...)                      \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(FATAL);                        \
-        char buf[1024] = {0};                             \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
-        exit(-1);                                         \
-    } while (0)
+#define LOG_TRACE(logmsgFormat, ...) \
+    LOG_WITH_LEVEL(TRACE, logmsgFormat, ##__VA_ARGS__)
+#define LOG_DEBUG(logmsgFormat, ...) \
+    LOG_WITH_LEVEL(DEBUG, logmsgFormat, ##__VA_ARGS__)
+#define LOG_INFO(logmsgFormat, ...) \
+    LOG_WITH_LEVEL(INFO, logmsgFormat, ##__VA_ARGS__)
+#define LOG_ERROR(logmsgFormat, ...) \
+    LOG_WITH_LEVEL(ERROR, logmsgFormat, ##__VA_ARGS__)
 
-// 调试时IO操作
-// 如果自己定义了MUDEBUG
-#ifdef MUDEBUG
-#define LOG_DEBUG(logmsgFormat, ...)                      \
-    do {                                                  \
-        Logger& logger = Logger::instance();              \
-        logger.setLogLevel(DEBUG);                        \
-        char buf[1024] = {0};                             \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf);                                  \
+// FATAL不受门限影响，输出之后直接退出
+#define LOG_FATAL(logmsgFormat, ...)                              \
+    do {                                                          \
+        char buf[1024];                                           \
+        snprintf(buf, sizeof buf, logmsgFormat, ##__VA_ARGS__);   \
+        Logger::instance().log(FATAL, buf);                       \
+        exit(-1);                                                 \
     } while (0)
-#else
-// 否则就什么也不用输出
-#define LOG_DEBUG(logmsgFormat, ...)
-#endif
-
-// 定义日志的级别 INFO RERROR FATAL（毁灭性错误） DEBUG（可选开关）
-enum LogLevel {
-    INFO,   // 普通信息
-    ERROR,  // 错误信息
-    FATAL,  // core信息
-    DEBUG,  // 调试信息
-};
 
 // 输出一个日志类，单例就好，不需要进行拷贝构造和赋值
+// Logger本身没有可变的状态，多个线程可以同时写日志
 class Logger : noncopyable {
 public:
+    // 日志的输出目的地，msg是拼好的一整行（带换行符）
+    using OutputFunc = void (*)(const char* msg, int len);
+    using FlushFunc = void (*)();
+
     // 获取日志唯一的实例对象
     // 用引用&，这样调用方法的时候方便，可以用.
     static Logger& instance();
-    // 设置日志级别
-    void setLogLevel(int level);
-    // 写日志
-    void log(std::string msg);
+    // 写日志，级别随每条日志一起传进来
+    void log(LogLevel level, const char* msg);
+
+    // 默认输出到stdout，可以换成AsyncLogging等后端
+    // 要在其他线程开始写日志之前设置
+    static void setOutput(OutputFunc out);
+    static void setFlush(FlushFunc flush);
+
+    // 运行期的日志门限，低于它的日志不输出（仍然受编译期门限MYNETLIB_MIN_LOG_LEVEL限制）
+    // 默认是INFO（定义了MUDEBUG时是DEBUG），环境变量MUDUO_LOG_TRACE/MUDUO_LOG_DEBUG可以调低
+    // 环境变量在第一次读门限时才生效，在那之前调用setMinLogLevel则以它为准
+    // 任何线程都可以随时修改，各线程用relaxed读，最终会看到新值
+    static LogLevel minLogLevel() {
+        int level = minLogLevel_.load(std::memory_order_relaxed);
+        if (level < 0) {
+            level = initMinLogLevel();
+        }
+        return static_cast<LogLevel>(level);
+    }
+    static void setMinLogLevel(LogLevel level) {
+        minLogLevel_.store(level, std::memory_order_relaxed);
+    }
 
 private:
-    // _logLevel; 和系统的变量不产生冲突
-    int logLevel_;
+    // 读环境变量确定初始门限，返回设置之后的门限
+    static int initMinLogLevel();
+
+    // 常量初始化（-1表示还没读环境变量），其他编译单元的静态初始化里写日志也不会读到未初始化的值
+    static std::atomic<int> minLogLevel_;
 };
 
 }
\ No newline at end of file
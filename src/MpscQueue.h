@@ -0,0 +1,89 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace mynetlib
+{
+
+/**
+ * 无锁的多生产者/单消费者队列（Dmitry Vyukov 的 MPSC 链表队列）
+ *
+ *   生产者: push 只做一次 exchange(head_) 和一次 store(next)，任意线程都可以调用
+ *   消费者: pop/consume 只允许一个线程（EventLoop 所在的线程）调用
+ *
+ * tail_ 始终指向一个哑结点，真正的数据从 tail_->next 开始；
+ * 弹出一个结点后，它就成为新的哑结点，旧的哑结点被释放。
+ */
+template <typename T>
+class MpscQueue : noncopyable {
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T value;
+        while (pop(&value)) {
+        }
+        delete tail_;
+    }
+
+    // 任意线程调用
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        // 先抢到链表尾的位置，再把前驱结点挂上来
+        // 两步之间消费者可能看到一个暂时断开的链表，pop 会把它当作空队列处理
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 只能在消费者线程调用，队列为空（或生产者正处于 push 中间）时返回false
+    bool pop(T* value) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        *value = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+
+    // 只能在消费者线程调用
+    // 只处理调用时已经入队的元素，func执行过程中新入队的元素留给下一次consume
+    // 返回处理的元素个数
+    template <typename Func>
+    size_t consume(Func&& func) {
+        Node* last = head_.load(std::memory_order_acquire);
+        size_t n = 0;
+        T value;
+        while (tail_ != last && pop(&value)) {
+            func(value);
+            ++n;
+        }
+        return n;
+    }
+
+    // 只在消费者线程中的判断是准确的
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        Node() : next(nullptr) {}
+        explicit Node(T&& v) : next(nullptr), value(std::move(v)) {}
+
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    // 生产者和消费者分别修改head_和tail_，放在不同的cache line上避免伪共享
+    alignas(64) std::atomic<Node*> head_;
+    alignas(64) Node* tail_;
+};
+
+}
@@ -0,0 +1,112 @@
+#include "PollPoller.h"
+#include "Channel.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <cassert>
+
+namespace mynetlib
+{
+
+PollPoller::PollPoller(EventLoop* loop) : Poller(loop) {}
+
+PollPoller::~PollPoller() = default;
+
+Timestamp PollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
+    LOG_TRACE("func=%s => fd total count:%lu \n", __FUNCTION__,
+              channels_.size());
+
+    int numEvents = ::poll(pollfds_.data(), pollfds_.size(), timeoutMs);
+    int saveErrno = errno;
+
+    Timestamp now(Timestamp::now());
+
+    if (numEvents > 0) {
+        LOG_TRACE("%d events happened \n", numEvents);
+        fillActiveChannels(numEvents, activeChannels);
+    } else if (numEvents == 0) {
+        LOG_TRACE("%s timeout! \n", __FUNCTION__);
+    } else {
+        if (saveErrno != EINTR) {
+            errno = saveErrno;
+            LOG_ERROR("PollPoller::poll() err!");
+        }
+    }
+    return now;
+}
+
+void PollPoller::fillActiveChannels(int numEvents,
+                                    ChannelList* activeChannels) const {
+    for (PollFdList::const_iterator pfd = pollfds_.begin();
+         pfd != pollfds_.end() && numEvents > 0; ++pfd) {
+        if (pfd->revents > 0) {
+            --numEvents;
+            ChannelMap::const_iterator ch = channels_.find(pfd->fd);
+            assert(ch != channels_.end());
+            Channel* channel = ch->second;
+            assert(channel->fd() == pfd->fd);
+            // poll和epoll的事件位在低16位上是一致的
+            channel->set_revents(pfd->revents);
+            activeChannels->push_back(channel);
+        }
+    }
+}
+
+void PollPoller::updateChannel(Channel* channel) {
+    LOG_TRACE("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__,
+              channel->fd(), channel->events(), channel->index());
+
+    if (channel->index() < 0) {
+        // 新的channel，追加到pollfds_末尾
+        assert(channels_.find(channel->fd()) == channels_.end());
+        struct pollfd pfd;
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events());
+        pfd.revents = 0;
+        pollfds_.push_back(pfd);
+        int idx = static_cast<int>(pollfds_.size()) - 1;
+        channel->set_index(idx);
+        channels_[pfd.fd] = channel;
+    } else {
+        // 已经存在的channel，直接修改对应的pollfd
+        assert(channels_.find(channel->fd()) != channels_.end());
+        assert(channels_[channel->fd()] == channel);
+        int idx = channel->index();
+        assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
+        struct pollfd& pfd = pollfds_[idx];
+        assert(pfd.fd == channel->fd() || pfd.fd == -channel->fd() - 1);
+        pfd.fd = channel->fd();
+        pfd.events = static_cast<short>(channel->events());
+        pfd.revents = 0;
+        if (channel->isNoneEvent()) {
+            // 负的fd会被poll忽略，-1是为了处理fd为0的情况
+            pfd.fd = -channel->fd() - 1;
+        }
+    }
+}
+
+void PollPoller::removeChannel(Channel* channel) {
+    LOG_TRACE("func=%s => fd=%d\n", __FUNCTION__, channel->fd());
+
+    assert(channels_.find(channel->fd()) != channels_.end());
+    assert(channels_[channel->fd()] == channel);
+    assert(channel->isNoneEvent());
+    int idx = channel->index();
+    assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
+
+    channels_.erase(channel->fd());
+    if (static_cast<size_t>(idx) != pollfds_.size() - 1) {
+        // 和最后一个元素交换后再删除，O(1)
+        int channelAtEnd = pollfds_.back().fd;
+        std::iter_swap(pollfds_.begin() + idx, pollfds_.end() - 1);
+        if (channelAtEnd < 0) {
+            channelAtEnd = -channelAtEnd - 1;
+        }
+        channels_[channelAtEnd]->set_index(idx);
+    }
+    pollfds_.pop_back();
+    channel->set_index(-1);
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Poller.h"
+#include "Timestamp.h"
+
+#include <vector>
+
+struct pollfd;
+
+namespace mynetlib
+{
+
+class Channel;
+
+/**
+ * 封装poll(2)的操作行为
+ * 不需要epoll_ctl，channel的增删改只是修改用户态的pollfd数组，
+ * fd很少的loop（比如只有listenfd的mainLoop、只有timerfd的loop）里比epoll开销更小
+ */
+class PollPoller : public Poller {
+public:
+    PollPoller(EventLoop* loop);
+    ~PollPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+private:
+    void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
+
+    // channel的index_就是它在pollfds_中的下标
+    using PollFdList = std::vector<struct pollfd>;
+    PollFdList pollfds_;
+};
+
+}
@@ -20,6 +20,14 @@ public:
     // Poller关注的Channel
     using ChannelList=std::vector<Channel*>;
 
+    // IO复用的具体实现，在构造EventLoop时选择
+    enum Type {
+        kDefault,   // 由环境变量决定（MUDUO_USE_POLL/MUDUO_USE_URING），默认epoll
+        kEPoll,
+        kPoll,      // fd很少的loop用poll更省，没有epoll_ctl的开销
+        kIoUring,   // 内核不支持时退回epoll
+    };
+
     Poller(EventLoop *loop);
     // 虚析构函数
     // 如果基类的析构函数不是虚函数，那么当通过基类指针或引用删除派生类对象时，
@@ -40,6 +48,8 @@ public:
     // EventLoop可以通过该接口获取默认的IO复用的具体实现
     // 但注意实现不在Poller.cc中，依赖倒置，在DefaultPoller.cc里面
     static Poller* newDefaultPoller(EventLoop *loop);
+    // 获取指定类型的IO复用实现
+    static Poller* newPoller(EventLoop *loop, Type type);
 
 protected:
     // map的key：sockfd  value：sockfd所属的channel通道类型
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mynetlib
+{
+
+/**
+ * 带小缓冲区的可调用对象，用法和std::function一样
+ *
+ * 不超过Capacity字节的函数对象（捕获了几个指针/整数/shared_ptr的lambda，std::bind的结果，
+ * 甚至一个std::function）直接放在对象内部，构造、移动都不分配内存；
+ * 更大的才放到堆上。std::function的内部缓冲区只有16字节，而且只给可平凡拷贝的类型用，
+ * 捕获了shared_ptr的lambda每次都要new
+ */
+template <typename Signature, size_t Capacity = 48>
+class SmallFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class SmallFunction<R(Args...), Capacity> {
+public:
+    SmallFunction() noexcept : ops_(nullptr) {}
+    SmallFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template <typename F,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type, SmallFunction>::value &&
+                  std::is_invocable_r<R, typename std::decay<F>::type&, Args...>::value>::type>
+    SmallFunction(F&& f) : ops_(nullptr) {
+        using Functor = typename std::decay<F>::type;
+        if (isEmpty(f)) {
+            return;
+        }
+        if constexpr (fitsInline<Functor>()) {
+            new (&storage_) Functor(std::forward<F>(f));
+            ops_ = &InlineOps<Functor>::ops;
+        } else {
+            HeapOps<Functor>::get(&storage_) = new Functor(std::forward<F>(f));
+            ops_ = &HeapOps<Functor>::ops;
+        }
+    }
+
+    SmallFunction(const SmallFunction& that) : ops_(that.ops_) {
+        if (ops_) {
+            ops_->copy(&storage_, &that.storage_);
+        }
+    }
+
+    SmallFunction(SmallFunction&& that) noexcept : ops_(that.ops_) {
+        if (ops_) {
+            ops_->move(&storage_, &that.storage_);
+            that.ops_ = nullptr;
+        }
+    }
+
+    SmallFunction& operator=(const SmallFunction& that) {
+        if (this != &that) {
+            SmallFunction tmp(that);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    SmallFunction& operator=(SmallFunction&& that) noexcept {
+        if (this != &that) {
+            reset();
+            if (that.ops_) {
+                that.ops_->move(&storage_, &that.storage_);
+                ops_ = that.ops_;
+                that.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    SmallFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    ~SmallFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 和std::function一样，空的时候调用抛出std::bad_function_call
+    R operator()(Args... args) const {
+        if (ops_ == nullptr) {
+            throw std::bad_function_call();
+        }
+        return ops_->invoke(const_cast<Storage*>(&storage_),
+                            std::forward<Args>(args)...);
+    }
+
+    // 析构函数对象，变成空的（比如回调里持有的shared_ptr需要尽早释放）
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    using Storage = typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type;
+
+    // 每种函数对象类型一张操作表，相当于手写的虚函数表
+    struct Ops {
+        R (*invoke)(Storage*, Args&&...);
+        void (*copy)(Storage* dst, const Storage* src);
+        void (*move)(Storage* dst, Storage* src) noexcept;  // 移动后析构src
+        void (*destroy)(Storage*) noexcept;
+    };
+
+    template <typename Functor>
+    static constexpr bool fitsInline() {
+        return sizeof(Functor) <= Capacity &&
+               alignof(std::max_align_t) % alignof(Functor) == 0 &&
+               std::is_nothrow_move_constructible<Functor>::value;
+    }
+
+    // 空的函数指针、空的std::function当作空的SmallFunction
+    template <typename F>
+    static bool isEmpty(const F& f) {
+        if constexpr (std::is_pointer<F>::value || std::is_member_pointer<F>::value) {
+            return f == nullptr;
+        } else if constexpr (std::is_same<F, std::function<R(Args...)>>::value) {
+            return !f;
+        } else {
+            return false;
+        }
+    }
+
+    template <typename Functor>
+    struct InlineOps {
+        static Functor* get(Storage* s) { return std::launder(reinterpret_cast<Functor*>(s)); }
+        static const Functor* get(const Storage* s) {
+            return std::launder(reinterpret_cast<const Functor*>(s));
+        }
+        static R invoke(Storage* s, Args&&... args) {
+            return std::invoke(*get(s), std::forward<Args>(args)...);
+        }
+        static void copy(Storage* dst, const Storage* src) { new (dst) Functor(*get(src)); }
+        static void move(Storage* dst, Storage* src) noexcept {
+            new (dst) Functor(std::move(*get(src)));
+            get(src)->~Functor();
+        }
+        static void destroy(Storage* s) noexcept { get(s)->~Functor(); }
+
+        static constexpr Ops ops = {invoke, copy, move, destroy};
+    };
+
+    template <typename Functor>
+    struct HeapOps {
+        static Functor*& get(Storage* s) { return *reinterpret_cast<Functor**>(s); }
+        static Functor* get(const Storage* s) { return *reinterpret_cast<Functor* const*>(s); }
+        static R invoke(Storage* s, Args&&... args) {
+            return std::invoke(*get(s), std::forward<Args>(args)...);
+        }
+        static void copy(Storage* dst, const Storage* src) {
+            get(dst) = new Functor(*get(src));
+        }
+        static void move(Storage* dst, Storage* src) noexcept {
+            get(dst) = get(src);
+            get(src) = nullptr;
+        }
+        static void destroy(Storage* s) noexcept { delete get(s); }
+
+        static constexpr Ops ops = {invoke, copy, move, destroy};
+    };
+
+    Storage storage_;
+    const Ops* ops_;
+};
+
+}
@@ -21,9 +21,9 @@ void Socket::bindAddress(const InetAddress& localaddr) {
     }
 }
 
-void Socket::listen() {
-    // 第二个参数是accept队列大小
-    if (0 != ::listen(sockfd_, 1024)) {
+void Socket::listen(int backlog) {
+    // 第二个参数是accept队列大小，内核会再用somaxconn截断
+    if (0 != ::listen(sockfd_, backlog)) {
         LOG_FATAL("listen sockfd:%d fail \n", sockfd_);
     }
 }
@@ -42,9 +42,8 @@ int Socket::accept(InetAddress* peeraddr) {
                            SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (connfd >= 0) {
         peeraddr->setSockAddr(addr);  // 通过输出参数传出连接到的对端的地址
-    } else {
-        LOG_FATAL("Socket accept sockfd error! errno=%d\n", errno);
     }
+    // 失败时不在这里退出：EAGAIN、EMFILE这些都是监听socket上的正常情况，由Acceptor处理
 
     return connfd;
 }
@@ -75,4 +74,24 @@ void Socket::setKeepAlive(bool on) {
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof optval);
 }
 
+bool Socket::setZeroCopy(bool on) {
+    int optval = on ? 1 : 0;
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval,
+                        sizeof optval) == 0;
+}
+
+bool Socket::setIncomingCpu(int cpu) {
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_INCOMING_CPU, &cpu,
+                        sizeof cpu) == 0;
+}
+
+int Socket::incomingCpu(int sockfd) {
+    int cpu = -1;
+    socklen_t len = sizeof cpu;
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0) {
+        return -1;
+    }
+    return cpu;
+}
+
 }  // namespace mynetlib
\ No newline at end of file
@@ -19,8 +19,9 @@ public:
         return sockfd_;
     }
     void bindAddress(const InetAddress &localaddr); // 调用bind绑定服务器IP端口
-    void listen(); // 调用listen监听套接字
-    int accept(InetAddress *peeraddr); // 调用accept接收新客户连接请求
+    void listen(int backlog = 1024); // 调用listen监听套接字，backlog是全连接队列的长度
+    // 调用accept接收新客户连接请求，失败时返回-1，errno由调用者处理（EAGAIN表示队列已经空了）
+    int accept(InetAddress *peeraddr);
 
     void shutdownWrite(); // 调用shutdown关闭服务端写通道
 
@@ -29,6 +30,13 @@ public:
     void setReuseAddr(bool on);
     void setReusePort(bool on);
     void setKeepAlive(bool on);
+    // SO_ZEROCOPY，之后才能用MSG_ZEROCOPY发送，内核不支持时返回false
+    bool setZeroCopy(bool on);
+    // SO_INCOMING_CPU：监听socket上设置后，SO_REUSEPORT的几个监听socket里
+    // 内核优先把连接交给和收到SYN的CPU一致的那个；内核不支持时返回false
+    bool setIncomingCpu(int cpu);
+    // 最后一次处理这个socket收包的CPU，取不到时返回-1
+    static int incomingCpu(int sockfd);
 
 private:
     const int sockfd_; // 服务器监听套接字文件描述符
@@ -0,0 +1,194 @@
+#include "SortedTimerQueue.h"
+#include "Timer.h"
+
+namespace mynetlib
+{
+
+SortedTimerQueue::SortedTimerQueue(EventLoop* loop)
+    : TimerQueue(loop),
+     callingExpiredTimers_(false)
+{
+}
+
+// 定时器的内存由pool_统一释放
+SortedTimerQueue::~SortedTimerQueue() = default;
+
+// 保证线程安全的操作
+void SortedTimerQueue::addTimerInLoop(TimerPtr timer)
+{
+    // 是否取代了最早的定时触发时间
+    bool earliestChanged = insert(timer);
+
+    // 我们需要重新设置timerfd_触发时间
+    if(earliestChanged)
+    {
+        resetTimerfd(timer->expiration());
+    }
+}
+
+void SortedTimerQueue::cancelInLoop(TimerPtr timer, int64_t sequence)
+{
+    // 已经到期回收（或者被复用成了别的定时器）
+    if(timer == nullptr || timer->sequece() != sequence)
+    {
+        return;
+    }
+    if(timer->heapIndex_ != Timer::kNotInHeap)
+    {
+        removeAt(timer->heapIndex_);
+        pool_.release(timer);
+    }
+    else if(callingExpiredTimers_)
+    {
+        // 在本轮到期的定时器里，还没执行的不再执行，重复的不再重启
+        timer->canceled_ = true;
+    }
+}
+
+void SortedTimerQueue::handleExpired(Timestamp now)
+{
+    getExpired(now);
+
+    // 遍历到期的定时器，调用回调函数
+    callingExpiredTimers_ = true;
+    for(TimerPtr timer : expired_)
+    {
+        // 被同一批里先执行的回调取消了
+        if(!timer->canceled_)
+        {
+            timer->run();
+        }
+    }
+    callingExpiredTimers_ = false;
+    // 重新设置这些定时器
+    reset(now);
+}
+
+//将所有超时的timer移除
+void SortedTimerQueue::getExpired(Timestamp now)
+{
+    expired_.clear();
+    while(!heap_.empty() && !(now < heap_.front()->expiration()))
+    {
+        expired_.push_back(heap_.front());
+        removeAt(0);
+    }
+}
+
+void SortedTimerQueue::reset(Timestamp now)
+{
+    for(TimerPtr timer : expired_)
+    {
+        // 重复任务则继续执行
+        //如果是runEvery事件，继续添加进堆中
+        if(timer->repeat() && !timer->canceled_)
+        {
+            timer->restart(now);
+            insert(timer);
+        }
+        else
+        {
+            pool_.release(timer);
+        }
+    }
+    expired_.clear();
+
+    // 如果重新插入了定时器，需要继续重置timerfd
+    if(!heap_.empty())
+    {
+        resetTimerfd(heap_.front()->expiration());
+    }
+}
+
+bool SortedTimerQueue::insert(TimerPtr timer)
+{
+    // 说明最早的定时器已经被替换了
+    bool earliestChanged = heap_.empty() || earlier(timer, heap_.front());
+    heap_.push_back(timer);
+    timer->heapIndex_ = heap_.size() - 1;
+    siftUp(heap_.size() - 1);
+    return earliestChanged;
+}
+
+// 到期时间相同时按创建顺序
+bool SortedTimerQueue::earlier(TimerPtr lhs, TimerPtr rhs)
+{
+    if(lhs->expiration() < rhs->expiration())
+    {
+        return true;
+    }
+    if(rhs->expiration() < lhs->expiration())
+    {
+        return false;
+    }
+    return lhs->sequece() < rhs->sequece();
+}
+
+void SortedTimerQueue::place(TimerPtr timer, size_t index)
+{
+    heap_[index] = timer;
+    timer->heapIndex_ = index;
+}
+
+void SortedTimerQueue::siftUp(size_t index)
+{
+    TimerPtr timer = heap_[index];
+    while(index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if(!earlier(timer, heap_[parent]))
+        {
+            break;
+        }
+        place(heap_[parent], index);
+        index = parent;
+    }
+    place(timer, index);
+}
+
+void SortedTimerQueue::siftDown(size_t index)
+{
+    TimerPtr timer = heap_[index];
+    size_t n = heap_.size();
+    while(true)
+    {
+        size_t child = index * 2 + 1;
+        if(child >= n)
+        {
+            break;
+        }
+        if(child + 1 < n && earlier(heap_[child + 1], heap_[child]))
+        {
+            ++child;
+        }
+        if(!earlier(heap_[child], timer))
+        {
+            break;
+        }
+        place(heap_[child], index);
+        index = child;
+    }
+    place(timer, index);
+}
+
+void SortedTimerQueue::removeAt(size_t index)
+{
+    TimerPtr timer = heap_[index];
+    TimerPtr last = heap_.back();
+    heap_.pop_back();
+    timer->heapIndex_ = Timer::kNotInHeap;
+    if(last != timer)
+    {
+        place(last, index);
+        if(index > 0 && earlier(last, heap_[(index - 1) / 2]))
+        {
+            siftUp(index);
+        }
+        else
+        {
+            siftDown(index);
+        }
+    }
+}
+
+}
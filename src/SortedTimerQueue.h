@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "TimerQueue.h"
+
+namespace mynetlib
+{
+
+// 按到期时间排序的定时器队列
+// 用二叉堆（vector）组织，Timer里记着自己在堆中的下标，添加/取消O(log n)且不分配内存
+// 每次最早的到期时间变化都重新设置timerfd，到期时间精确到微秒
+class SortedTimerQueue : public TimerQueue
+{
+public:
+    explicit SortedTimerQueue(EventLoop* loop);
+    ~SortedTimerQueue() override;
+
+    size_t size() const override { return heap_.size(); }
+
+private:
+    using TimerPtr = Timer*;
+    using TimerList = std::vector<TimerPtr>;
+
+    // 保证线程安全的操作
+    void addTimerInLoop(TimerPtr timer) override;
+    void cancelInLoop(TimerPtr timer, int64_t sequence) override;
+    void handleExpired(Timestamp now) override;
+
+    // 取出所有已到期的定时器，放到expired_里
+    void getExpired(Timestamp now);
+    // 重置这些定时器（回收或者重复定时任务）
+    void reset(Timestamp now);
+
+    // 插入定时器的内部方法，返回最早的到期时间是否变了
+    bool insert(TimerPtr timer);
+
+    // 堆操作，同时维护Timer::heapIndex_
+    static bool earlier(TimerPtr lhs, TimerPtr rhs);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void removeAt(size_t index);
+    void place(TimerPtr timer, size_t index);
+
+    // 按Expiration时间组织的小根堆
+    TimerList heap_;
+    // 本轮到期的定时器，成员变量反复使用，避免每次分配
+    TimerList expired_;
+    bool callingExpiredTimers_; // 正在获取超时定时器标志
+};
+
+}
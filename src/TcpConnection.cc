@@ -5,15 +5,27 @@
 #include "Socket.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <strings.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace mynetlib {
 // 写个静态的，不会因为编译名字冲突
+// 连接销毁后，还在零拷贝发送中的payload再持有的时间
+static const double kZeroCopyLingerSeconds = 120.0;
+
 static EventLoop* CheckLoopNotNull(EventLoop* loop) {
     if (loop == nullptr) {
         LOG_FATAL("%s:%s:%d TcpConnection Loop is null! \n", __FILE__,
@@ -27,16 +39,26 @@ TcpConnection::TcpConnection(EventLoop* loop,
                              const std::string& nameArg,
                              int sockfd,
                              const InetAddress& localAddr,
-                             const InetAddress& peerAddr)
+                             const InetAddress& peerAddr,
+                             uint64_t id)
     : loop_(CheckLoopNotNull(loop)),
       name_(nameArg),
+      id_(id),
       state_(kConnecting),
       reading_(true),
       socket_(new Socket(sockfd)),
       channel_(new Channel(loop, sockfd)),
       localAddr_(localAddr),
       peerAddr_(peerAddr),
-      highWaterMark_(64 * 1024 * 1024)  // 64M
+      highWaterMark_(64 * 1024 * 1024),  // 64M
+      lowWaterMark_(0),
+      aboveHighWaterMark_(false),
+      inputHighWaterMark_(0),
+      readBudgetBytes_(0),
+      readBudgetReads_(0),
+      readPending_(false),
+      zeroCopyMinBytes_(0),
+      zeroCopyNextId_(0)
 {
     // 下面给channel设置相应的回调函数，poller给channel通知感兴趣的事件发生了，channel会回调相应的操作函数
     channel_->setReadCallback(
@@ -54,32 +76,109 @@ TcpConnection::TcpConnection(EventLoop* loop,
 TcpConnection::~TcpConnection() {
     LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%d \n", name_.c_str(),
              channel_->fd(), (int)state_);
+    for (const OutputRegion& region : outputRegions_) {
+        if (region.fd >= 0) {
+            ::close(region.fd);
+        }
+    }
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime) {
+    // 推迟处理的事件可能在stopRead之后才轮到
+    if (!reading_) {
+        return;
+    }
+    lastActive_ = receiveTime;
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
-    if (n > 0) {
-        // 已建立连接的用户，有可读事件发生了，调用用户传入的回调操作onMessage
-        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
-    } else if (n == 0) {
+    ssize_t n = 0;
+    // 水平触发每次事件只读一次；边沿触发下这次不读完，内核不会再通知，
+    // 一直读到EAGAIN/对端关闭（每读一次就回调一次，inputBuffer_不会无限增长）
+    // 设置了读预算时以预算为准
+    const bool edgeTriggered = channel_->isEdgeTriggered();
+    const int maxReads = readBudgetReads_ > 0 ? readBudgetReads_
+                         : edgeTriggered      ? INT_MAX
+                                              : 1;
+    int reads = 0;
+    size_t bytes = 0;
+    do {
+        n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+        if (n > 0) {
+            ++reads;
+            bytes += n;
+            // 已建立连接的用户，有可读事件发生了，调用用户传入的回调操作onMessage
+            messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+            // 应用没来得及处理的数据太多了，先不读，等它调用startRead
+            if (inputHighWaterMark_ > 0 &&
+                inputBuffer_.readableBytes() >= inputHighWaterMark_ &&
+                reading_) {
+                LOG_DEBUG("TcpConnection::handleRead [%s] pause reading, "
+                          "%zu bytes buffered\n",
+                          name_.c_str(), inputBuffer_.readableBytes());
+                stopReadInLoop();
+            }
+        }
+    } while (n > 0 && channel_->isReading() && reads < maxReads &&
+             (readBudgetBytes_ == 0 || bytes < readBudgetBytes_));
+
+    // 预算用完了，内核里可能还有数据：LT下poller会再上报，ET下不会，排到后面接着读
+    if (n > 0 && edgeTriggered && channel_->isReading() && !readPending_) {
+        readPending_ = true;
+        loop_->queueInLoop(
+            std::bind(&TcpConnection::continueRead, shared_from_this()));
+    }
+
+    if (n == 0) {
         // 出错了，close
         handleClose();
-    } else {
+    } else if (n < 0 && savedErrno != EAGAIN && savedErrno != EWOULDBLOCK) {
         errno = savedErrno;
         LOG_ERROR("TcpConnection::handleRead");
         handleError();
+        // 边沿触发下不会再有后续的事件通知来发现连接已经断开，直接关闭
+        if (channel_->isEdgeTriggered()) {
+            handleClose();
+        }
+    }
+}
+
+void TcpConnection::continueRead() {
+    readPending_ = false;
+    if ((state_ == kConnected || state_ == kDisconnecting) &&
+        channel_->isReading()) {
+        handleRead(loop_->pollReturnTime());
     }
 }
 
 void TcpConnection::handleWrite() {
     if (channel_->isWriting()) {
+        lastActive_ = loop_->pollReturnTime();
         int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
-        if (n > 0) {
+        ssize_t n = 0;
+        bool wrote = false;
+        // 水平触发每次事件只写一次；边沿触发下一直写到发完或者EAGAIN
+        do {
+            n = writeOutput(&savedErrno);
+            if (n > 0) {
+                wrote = true;
+            }
+        } while (n > 0 && channel_->isEdgeTriggered() && !outputEmpty());
+
+        // 回落到低水位，通知生产者恢复
+        if (aboveHighWaterMark_) {
+            size_t pending = outputBytes();
+            if (pending <= lowWaterMark_) {
+                aboveHighWaterMark_ = false;
+                if (lowWaterMarkCallback_) {
+                    loop_->queueInLoop(std::bind(lowWaterMarkCallback_,
+                                                 shared_from_this(), pending));
+                }
+            }
+        }
+
+        // 文件提前到头时区间会被直接丢掉，这时也可能没写出数据但已经发完了
+        if (wrote || outputEmpty()) {
             // 表示有数据发送成功
-            outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0) {
+            if (outputEmpty()) {
                 channel_->disableWriting();
                 if (writeCompleteCallback_) {
                     // 唤醒loop_对应的thread线程，执行回调
@@ -101,6 +200,135 @@ void TcpConnection::handleWrite() {
     }
 }
 
+size_t TcpConnection::outputBytes() const {
+    size_t bytes = outputBuffer_.readableBytes();
+    for (const OutputRegion& region : outputRegions_) {
+        bytes += region.remaining;
+    }
+    return bytes;
+}
+
+void TcpConnection::checkHighWaterMark(size_t oldLen, size_t newLen) {
+    // 上一次若已经超过高水位，不需要调用回调
+    if (newLen >= highWaterMark_ && oldLen < highWaterMark_) {
+        aboveHighWaterMark_ = true;
+        if (highWaterMarkCallback_) {
+            loop_->queueInLoop(std::bind(highWaterMarkCallback_,
+                                         shared_from_this(), newLen));
+        }
+    }
+}
+
+ssize_t TcpConnection::writeOutput(int* savedErrno) {
+    if (!outputRegions_.empty() && outputRegions_.front().bufferedBefore == 0) {
+        ssize_t n = writeRegion(&outputRegions_.front(), savedErrno);
+        if (outputRegions_.front().remaining == 0) {
+            outputRegions_.pop_front();
+        }
+        return n;
+    }
+    // 只发送到下一个区间之前
+    size_t limit = outputRegions_.empty()
+                       ? ChainBuffer::npos
+                       : outputRegions_.front().bufferedBefore;
+    ssize_t n = outputBuffer_.writeFd(channel_->fd(), savedErrno, limit);
+    if (n > 0) {
+        outputBuffer_.retrieve(n);
+        if (!outputRegions_.empty()) {
+            outputRegions_.front().bufferedBefore -= n;
+        }
+    }
+    return n;
+}
+
+ssize_t TcpConnection::writeRegion(OutputRegion* region, int* savedErrno) {
+    ssize_t n;
+    if (region->payload) {
+        struct iovec vec;
+        vec.iov_base = const_cast<char*>(region->payload->data() + region->offset);
+        vec.iov_len = region->remaining;
+        struct msghdr msg = {};
+        msg.msg_iov = &vec;
+        msg.msg_iovlen = 1;
+        n = ::sendmsg(channel_->fd(), &msg, MSG_ZEROCOPY | MSG_NOSIGNAL);
+        if (n > 0) {
+            // 每次成功的MSG_ZEROCOPY发送占一个编号，完成通知里是编号的区间
+            zeroCopyInFlight_.emplace_back(zeroCopyNextId_++, region->payload);
+        } else if (n < 0 && errno == ENOBUFS) {
+            // 锁定的页超过了optmem限制，这一次退回普通的拷贝发送
+            n = ::send(channel_->fd(), vec.iov_base, vec.iov_len, MSG_NOSIGNAL);
+        }
+        if (n > 0) {
+            region->offset += n;
+        }
+    } else if (region->pipe) {
+        // 管道里的数据被splice搬到socket，不经过用户空间
+        n = ::splice(region->fd, nullptr, channel_->fd(), nullptr,
+                     region->remaining, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    } else {
+        // sendfile会更新offset，不改变文件本身的读写位置
+        n = ::sendfile(channel_->fd(), region->fd, &region->offset,
+                       region->remaining);
+    }
+    if (n > 0) {
+        region->remaining -= n;
+    } else if (n < 0) {
+        *savedErrno = errno;
+    } else if (region->fd >= 0) {
+        // 文件已经到头（被截断了）/管道的写端关闭了，剩下的发不出去了
+        LOG_ERROR("TcpConnection::writeRegion [%s] %zu bytes missing\n",
+                  name_.c_str(), region->remaining);
+        region->remaining = 0;
+    }
+    if (region->remaining == 0 && region->fd >= 0) {
+        ::close(region->fd);
+        region->fd = -1;
+    }
+    return n;
+}
+
+bool TcpConnection::handleZeroCopyCompletions() {
+    bool got = false;
+    char control[128];
+    for (;;) {
+        struct msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+        if (::recvmsg(channel_->fd(), &msg, MSG_ERRQUEUE) < 0) {
+            break;
+        }
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 &&
+                   cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            const struct sock_extended_err* err =
+                reinterpret_cast<const struct sock_extended_err*>(
+                    CMSG_DATA(cm));
+            if (err->ee_errno != 0 ||
+                err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            got = true;
+            // [ee_info, ee_data] 这个区间的发送都已经完成，内核不再引用这些页
+            // COPIED表示内核最终还是拷贝了（比如发往本机的连接），零拷贝没有省下什么
+            uint32_t hi = err->ee_data;
+            LOG_TRACE("TcpConnection [%s] zerocopy done [%u, %u]%s\n",
+                      name_.c_str(), err->ee_info, hi,
+                      err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED ? " copied"
+                                                                : "");
+            while (!zeroCopyInFlight_.empty() &&
+                   static_cast<int32_t>(zeroCopyInFlight_.front().first - hi) <=
+                       0) {
+                zeroCopyInFlight_.pop_front();
+            }
+        }
+    }
+    return got;
+}
+
 // poller => channel::closeCallback => TcpConnection::handleClose
 void TcpConnection::handleClose() {
     LOG_INFO("fd=%d state=%d \n", channel_->fd(), (int)state_);
@@ -115,6 +343,10 @@ void TcpConnection::handleClose() {
 }
 
 void TcpConnection::handleError() {
+    // 开启零拷贝后，发送完成的通知也是以EPOLLERR的形式报上来的
+    if (!zeroCopyInFlight_.empty() && handleZeroCopyCompletions()) {
+        return;
+    }
     int optval;
     socklen_t optlen = sizeof optval;
     int err = 0;
@@ -129,24 +361,112 @@ void TcpConnection::handleError() {
 }
 
 // 干脆直接提供string作为参数，用户用起来方便一点
+// 跨线程时要拷贝一份：buf是调用者的，回调真正执行时它可能已经不在了
 void TcpConnection::send(const std::string& buf) {
     if (state_ == kConnected) {
         if (loop_->isInLoopThread()) {
-            sendInLoop(buf.c_str(), buf.size());
+            sendInLoop(buf.data(), buf.size());
+        } else {
+            send(std::string(buf));
+        }
+    }
+}
+
+void TcpConnection::send(std::string&& buf) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(std::move(buf));
+        } else {
+            // 唤醒Loop所属线程执行send，string移动进回调里，回调持有连接保证它还活着
+            // 走不走零拷贝要到loop线程里再决定，zeroCopyMinBytes_只在loop线程中读写
+            loop_->runInLoop([conn = shared_from_this(),
+                              message = std::move(buf)]() mutable {
+                conn->sendInLoop(std::move(message));
+            });
+        }
+    }
+}
+
+void TcpConnection::send(Buffer* buf) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
+        } else {
+            // 和一个空的Buffer交换，数据本身不拷贝
+            Buffer message(0);
+            message.swap(*buf);
+            loop_->runInLoop(
+                [conn = shared_from_this(), message = std::move(message)] {
+                    conn->sendInLoop(message.peek(), message.readableBytes());
+                });
+        }
+    }
+}
+
+void TcpConnection::send(const PayloadPtr& payload) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendPayloadInLoop(payload);
+        } else {
+            loop_->runInLoop([conn = shared_from_this(), payload] {
+                conn->sendPayloadInLoop(payload);
+            });
+        }
+    }
+}
+
+void TcpConnection::send(const struct iovec* iov, int iovcnt) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(iov, iovcnt);
         } else {
-            // 唤醒Loop所属线程执行send
-            loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, this,
-                                       buf.c_str(), buf.size()));
+            // iov指向的内存调用返回后就可能失效，只能拷贝一份带过去
+            size_t len = 0;
+            for (int i = 0; i < iovcnt; ++i) {
+                len += iov[i].iov_len;
+            }
+            std::string message;
+            message.reserve(len);
+            for (int i = 0; i < iovcnt; ++i) {
+                message.append(static_cast<const char*>(iov[i].iov_base),
+                               iov[i].iov_len);
+            }
+            loop_->runInLoop(
+                [conn = shared_from_this(), message = std::move(message)] {
+                    conn->sendInLoop(message.data(), message.size());
+                });
         }
     }
 }
 
+void TcpConnection::sendInLoop(std::string&& message) {
+    if (useZeroCopy(message.size())) {
+        // 移动到共享的payload里，零拷贝发送期间由连接持有
+        sendPayloadInLoop(
+            std::make_shared<const std::string>(std::move(message)));
+    } else {
+        sendInLoop(message.data(), message.size());
+    }
+}
+
+void TcpConnection::sendInLoop(const void* data, size_t len) {
+    struct iovec vec;
+    vec.iov_base = const_cast<void*>(data);
+    vec.iov_len = len;
+    sendInLoop(&vec, 1);
+}
+
 /**
  * 发送数据时，若应用写的快，而内核发送数据慢，需要把待发送数据写入缓冲区，
  * 而且设置了水位回调
  */
-void TcpConnection::sendInLoop(const void* data, size_t len) {
+void TcpConnection::sendInLoop(const struct iovec* iov, int iovcnt) {
     ssize_t nwrote = 0;
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        len += iov[i].iov_len;
+    }
     size_t remaining = len;  // 每一次写后，剩余没写的数据量
     bool faultError = false;
 
@@ -159,10 +479,14 @@ void TcpConnection::sendInLoop(const void* data, size_t len) {
     // !!if no thing in output queue, try writing directly
     // 表示channel_第一次开始写数据， 且缓冲区无待发数据,则可以直接发data数据
     // 否则要将数据加入到 outputBuffer_ 后发送
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        // 那就开始发送
-        nwrote = ::write(channel_->fd(), data, len);
+    if (!channel_->isWriting() && outputEmpty()) {
+        // 那就开始发送，多段数据一次writev（一次最多IOV_MAX段，剩下的进缓冲区）
+        nwrote = ::writev(channel_->fd(), iov, std::min(iovcnt, IOV_MAX));
         if (nwrote >= 0) {
+            if (nwrote > 0) {
+                // 直接写出去的也算活跃，只发不收的连接不能被当成空闲关掉
+                lastActive_ = loop_->pollReturnTime();
+            }
             remaining = len - nwrote;
             if (remaining == 0 && writeCompleteCallback_) {
                 // 既然在这里数据全部发送完成，就不用再给channel设置epollout事件了
@@ -188,16 +512,21 @@ void TcpConnection::sendInLoop(const void* data, size_t len) {
     // 注册epollout事件，poller发现tcp的发送缓冲区有内容可发，会通知相应的sock-channel，调用Channel::writeCallback_回调方法
     // 也就是调用TcpConnection::handleWrite方法，把发送缓冲区中的数据全部发送完成
     if (!faultError && remaining > 0) {
-        // 目前发送缓冲区剩余的待发送数据的长度
-        size_t oldLen = outputBuffer_.readableBytes();
-        // 上一次若已经超过高水位，不需要调用回调
-        if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_ &&
-            highWaterMark_) {
-            loop_->queueInLoop(std::bind(highWaterMarkCallback_,
-                                         shared_from_this(),
-                                         oldLen + remaining));
+        // 目前剩余的待发送数据的长度（包括排队的区间）
+        size_t oldLen = outputBytes();
+        checkHighWaterMark(oldLen, oldLen + remaining);
+        // 跳过已经写出去的nwrote字节，剩下的每一段依次追加，不需要先拼接
+        size_t skip = nwrote;
+        for (int i = 0; i < iovcnt; ++i) {
+            const char* base = static_cast<const char*>(iov[i].iov_base);
+            size_t n = iov[i].iov_len;
+            if (skip >= n) {
+                skip -= n;
+                continue;
+            }
+            outputBuffer_.append(base + skip, n - skip);
+            skip = 0;
         }
-        outputBuffer_.append((char*)data + nwrote, remaining);
         if (!channel_->isWriting()) {
             channel_
                 ->enableWriting();  // 这里一定要注册channel的写事件，否则poller不会给channel通知epollout
@@ -205,6 +534,99 @@ void TcpConnection::sendInLoop(const void* data, size_t len) {
     }
 }
 
+void TcpConnection::sendFile(int fd, off_t offset, size_t length) {
+    if (state_ == kConnected && length > 0) {
+        // 连接自己持有一份fd，调用者不用等发完才关闭
+        int ownedFd = ::dup(fd);
+        if (ownedFd < 0) {
+            LOG_ERROR("TcpConnection::sendFile dup fd=%d", fd);
+            return;
+        }
+        if (loop_->isInLoopThread()) {
+            sendFileInLoop(ownedFd, offset, length);
+        } else {
+            loop_->runInLoop([conn = shared_from_this(), ownedFd, offset,
+                              length] {
+                conn->sendFileInLoop(ownedFd, offset, length);
+            });
+        }
+    }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length) {
+    if (state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up writing!");
+        ::close(fd);
+        return;
+    }
+
+    struct stat st;
+    OutputRegion region;
+    region.fd = fd;
+    region.offset = offset;
+    region.remaining = length;
+    region.pipe = ::fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    sendRegionInLoop(region);
+}
+
+void TcpConnection::sendPayloadInLoop(const PayloadPtr& payload) {
+    if (!useZeroCopy(payload->size())) {
+        sendInLoop(payload->data(), payload->size());
+        return;
+    }
+    if (state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up writing!");
+        return;
+    }
+    OutputRegion region;
+    region.remaining = payload->size();
+    region.payload = payload;
+    sendRegionInLoop(region);
+}
+
+void TcpConnection::sendRegionInLoop(OutputRegion& region) {
+    // outputBuffer_里排在所有已有区间之后的数据，要在这个区间之前发
+    region.bufferedBefore = outputBuffer_.readableBytes();
+    for (const OutputRegion& queued : outputRegions_) {
+        region.bufferedBefore -= queued.bufferedBefore;
+    }
+
+    // 没有待发的数据，直接发送
+    if (!channel_->isWriting() && outputEmpty()) {
+        int savedErrno = 0;
+        ssize_t n = writeRegion(&region, &savedErrno);
+        if (n > 0) {
+            lastActive_ = loop_->pollReturnTime();
+        }
+        if (n < 0 && savedErrno != EAGAIN) {
+            errno = savedErrno;
+            LOG_ERROR("TcpConnection::sendRegionInLoop");
+            if (savedErrno == EPIPE || savedErrno == ECONNRESET) {
+                if (region.fd >= 0) {
+                    ::close(region.fd);
+                }
+                return;
+            }
+        }
+        if (region.remaining == 0) {
+            // 已经全部发出去了
+            if (writeCompleteCallback_) {
+                loop_->queueInLoop(
+                    std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            return;
+        }
+    }
+
+    // 剩下的部分排队，等epollout时由handleWrite按顺序发送
+    size_t oldLen = outputBytes();
+    checkHighWaterMark(oldLen, oldLen + region.remaining);
+    outputRegions_.push_back(std::move(region));
+    if (!channel_->isWriting()) {
+        channel_->enableWriting();
+    }
+}
+
 // 每一个loop所执行的方法，都要在loop对应的线程里去处理
 void TcpConnection::shutdown() {
     if (state_ == kConnected) {
@@ -213,10 +635,75 @@ void TcpConnection::shutdown() {
     }
 }
 
+void TcpConnection::forceClose() {
+    if (state_ == kConnected || state_ == kDisconnecting) {
+        setState(kDisconnecting);
+        // 持有shared_ptr，保证执行时连接对象还在
+        loop_->queueInLoop(
+            std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop() {
+    if (state_ == kConnected || state_ == kDisconnecting) {
+        // 和对端关闭一样处理
+        handleClose();
+    }
+}
+
 void TcpConnection::setTcpNoDelay(bool on) {
     socket_->setTcpNoDelay(on);
 }
 
+bool TcpConnection::setZeroCopy(size_t minBytes) {
+    if (minBytes > 0 && !socket_->setZeroCopy(true)) {
+        LOG_ERROR("TcpConnection::setZeroCopy [%s] SO_ZEROCOPY not supported\n",
+                  name_.c_str());
+        zeroCopyMinBytes_ = 0;
+        return false;
+    }
+    zeroCopyMinBytes_ = minBytes;
+    return true;
+}
+
+void TcpConnection::setReadBudget(size_t maxBytes, int maxReads) {
+    readBudgetBytes_ = maxBytes;
+    readBudgetReads_ = maxReads;
+}
+
+void TcpConnection::startRead() {
+    loop_->runInLoop(
+        std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop() {
+    if (!reading_ || !channel_->isReading()) {
+        // 重新注册EPOLLIN，内核里积压的数据会马上再上报（ET下修改事件也会重新检查就绪状态）
+        if (state_ == kConnected || state_ == kDisconnecting) {
+            channel_->enableReading();
+        }
+        reading_ = true;
+    }
+}
+
+void TcpConnection::stopRead() {
+    loop_->runInLoop(
+        std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopReadInLoop() {
+    if (reading_ || channel_->isReading()) {
+        if (channel_->isReading()) {
+            channel_->disableReading();
+        }
+        reading_ = false;
+    }
+}
+
+void TcpConnection::setEdgeTriggered(bool on) {
+    channel_->setEdgeTriggered(on);
+}
+
 void TcpConnection::shutdownInLoop() {
     // 保证优雅关闭，发完数据才关闭
     // 不关注channel_的写事件了，表明outputBuffer中数据已全部发送完成
@@ -231,21 +718,41 @@ void TcpConnection::shutdownInLoop() {
 // channel、socket、acceptor是不会直接给到用户手里的
 void TcpConnection::connectEstablished() {
     setState(kConnected);
+    lastActive_ = loop_->pollReturnTime();
     // 检测Channel对应的TcpConnection的生命期
     // 防止对应的Channel在销毁后仍被调用其回调
     channel_->tie(shared_from_this());
-    channel_->enableReading();  // 向poller注册channel的epollin事件
+    // 向poller注册channel的epollin事件，建立之前已经stopRead的就先不读
+    if (reading_) {
+        channel_->enableReading();
+    }
 
     // 新连接建立，执行回调
     connectionCallback_(shared_from_this());  // 用户定义的函数
 }
 // 连接销毁
 void TcpConnection::connectDestroyed() {
-    if (state_ == kConnected) {
+    // 调用过shutdown（kDisconnecting）的连接也可能在TcpServer析构时直接被销毁
+    if (state_ == kConnected || state_ == kDisconnecting) {
         setState(kDisconnected);
         channel_->disableAll();  // 把channel的所有感兴趣的事件，从poller中del掉
         connectionCallback_(shared_from_this()); //用户设置的回调
     }
+    // 零拷贝发送的页可能还在内核的发送队列里，socket关闭后内核仍会继续发送，
+    // 没等到完成通知的payload交给loop延迟释放，不能随连接一起析构
+    if (!zeroCopyInFlight_.empty()) {
+        handleZeroCopyCompletions();
+    }
+    if (!zeroCopyInFlight_.empty()) {
+        std::vector<PayloadPtr> payloads;
+        payloads.reserve(zeroCopyInFlight_.size());
+        for (auto& inFlight : zeroCopyInFlight_) {
+            payloads.push_back(std::move(inFlight.second));
+        }
+        zeroCopyInFlight_.clear();
+        loop_->runAfter(kZeroCopyLingerSeconds,
+                        [payloads = std::move(payloads)] {});
+    }
     channel_->remove();  // 把channel从poller中删除掉（从map中删掉）
 }
 
@@ -1,14 +1,20 @@
 #pragma once
 
 #include "Buffer.h"
+#include "ChainBuffer.h"
 #include "Callbacks.h"
 #include "InetAddress.h"
 #include "Timestamp.h"
 #include "noncopyable.h"
 
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <string>
+#include <utility>
 #include <any>
 
 namespace mynetlib
@@ -32,17 +38,19 @@ class Socket;
 class TcpConnection : noncopyable,
                       public std::enable_shared_from_this<TcpConnection> {
 public:
-    // sockfd是TcpServer给我的
+    // sockfd是TcpServer给我的，id是TcpServer分配的连接编号
     TcpConnection(EventLoop* loop,
                   const std::string& name,
                   int sockfd,
                   const InetAddress& localAddr,
-                  const InetAddress& peerAddr);
+                  const InetAddress& peerAddr,
+                  uint64_t id = 0);
     ~TcpConnection();
 
     EventLoop* getLoop() const { return loop_; }
     // getLoopName
     const std::string& name() const { return name_; }
+    uint64_t id() const { return id_; }
     const InetAddress& localAddress() const { return localAddr_; }
     const InetAddress& peerAddress() const { return peerAddr_; }
 
@@ -50,10 +58,52 @@ public:
     bool connected() const { return state_ == kConnected; }
 
     // 发送数据
+    // 不在loop线程中调用时，数据的所有权会随回调一起转交给loop线程：
+    //   const std::string& 拷贝一份；std::string&& 移动进去；
+    //   Buffer* 和一个空Buffer交换（调用后buf为空）；PayloadPtr 只增加引用计数
     void send(const std::string& buf);
+    void send(std::string&& buf);
+    void send(Buffer* buf);
+    void send(const PayloadPtr& payload);
+    // 分散发送：几段不连续的数据（比如响应头 + 正文）用一次writev发出去，不需要先拼接
+    // 发不完的部分直接追加到outputBuffer_；不在loop线程中调用时，会先拷贝成一个string再转交
+    void send(const struct iovec* iov, int iovcnt);
+    // 零拷贝发送fd的[offset, offset + length)：普通文件用sendfile，管道用splice（忽略offset）
+    // 和send的数据严格按调用顺序发出；fd会先dup一份，调用返回后就可以关闭自己的fd
+    // 管道里的length字节应当已经（或者很快会）写好，管道空着时loop会不停地收到可写事件
+    void sendFile(int fd, off_t offset, size_t length);
+    // 大块数据用MSG_ZEROCOPY发送：不小于minBytes的 send(std::string&&) / send(PayloadPtr)
+    // 直接把payload的页交给网卡，payload一直持有到内核通过错误队列通知发送完成为止
+    // minBytes为0表示关闭（默认）；内核不支持SO_ZEROCOPY时返回false
+    // 数据很小时（几十KB以下）通知的开销比拷贝还大，官方建议10KB以上才用
+    // 在connectEstablished之前，或者在所属loop线程中调用
+    // 注意：连接销毁时还没收到完成通知的payload，内核发送队列里的skb可能仍然引用着它的页
+    // （close之后内核还会继续发送没发完的数据），所以connectDestroyed把它们交给loop，
+    // 再持有120秒才释放；对端长时间不确认时仍可能早于内核释放，
+    // payload在此期间不要被修改（PayloadPtr本来就是只读的）
+    bool setZeroCopy(size_t minBytes);
     // 关闭连接，外部要调用的不能写到私有里面
     void shutdown();
+    // 不等待发完数据，直接关闭连接（比如空闲超时）
+    void forceClose();
     void setTcpNoDelay(bool on);
+    // 边沿触发模式：handleRead/handleWrite一直读/写到EAGAIN，减少大块数据传输时的epoll_wait返回次数
+    // 在connectEstablished之前，或者在所属loop线程中调用
+    void setEdgeTriggered(bool on);
+    // 读预算：一次读事件最多读maxReads次、maxBytes字节（0表示不限制），用完后让出loop，
+    // 剩下的数据留到后面（LT等poller再次上报，ET排进pendingFunctors），避免一个连接占住整个loop
+    // 默认 LT每次事件读一次，ET一直读到EAGAIN
+    // 在connectEstablished之前，或者在所属loop线程中调用
+    void setReadBudget(size_t maxBytes, int maxReads);
+    // 暂停/恢复读：下游处理不过来时停止从socket读数据，让内核接收窗口把压力传回对端
+    // 任意线程都可以调用
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; }  // 只在loop线程中准确
+    // 输入高水位：inputBuffer_里未处理的数据达到bytes时自动stopRead，0表示不限制（默认）
+    // 应用把inputBuffer_里的数据处理掉以后调用startRead恢复
+    void setInputHighWaterMark(size_t bytes) { inputHighWaterMark_ = bytes; }
+    Buffer* inputBuffer() { return &inputBuffer_; }
 
     void setConnectionCallback(const ConnectionCallback& cb) {
         connectionCallback_ = cb;
@@ -67,12 +117,21 @@ public:
         writeCompleteCallback_ = cb;
     }
 
+    // 待发送的数据（outputBuffer_加上sendFile/零拷贝排队的区间）越过highWaterMark时回调一次
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb,
                                   size_t highWaterMark) {
         highWaterMarkCallback_ = cb;
         highWaterMark_ = highWaterMark;
     }
 
+    // 和高水位回调配对：待发送的数据越过高水位之后，又发送到不超过lowWaterMark时回调一次，
+    // 用来恢复在高水位回调里暂停的生产者
+    void setLowWaterMarkCallback(const LowWaterMarkCallback& cb,
+                                 size_t lowWaterMark) {
+        lowWaterMarkCallback_ = cb;
+        lowWaterMark_ = lowWaterMark;
+    }
+
     void setCloseCallback(const CloseCallback& cb) { closeCallback_ = cb; }
 
     // 连接建立
@@ -85,6 +144,9 @@ public:
 
     std::any* getMutableContext() { return &context_; }
 
+    // 最后一次收到/发出数据的时间（poller返回的时间），只在loop线程中读
+    Timestamp lastActive() const { return lastActive_; }
+
 private:
     enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
     void setState(StateE state) { state_ = state; }
@@ -94,12 +156,55 @@ private:
     void handleClose();
     void handleError();
 
+    void sendInLoop(std::string&& message);
     void sendInLoop(const void* message, size_t len);
+    void sendInLoop(const struct iovec* iov, int iovcnt);
+    void sendFileInLoop(int fd, off_t offset, size_t length);
+    void sendPayloadInLoop(const PayloadPtr& payload);
     void shutdownInLoop();
+    void forceCloseInLoop();
+    void startReadInLoop();
+    void stopReadInLoop();
+    // ET模式下读预算用完后接着读
+    void continueRead();
+
+    // 排队等待发送、不经过outputBuffer_的区间：文件，或者零拷贝发送的payload
+    struct OutputRegion {
+        OutputRegion()
+            : fd(-1), offset(0), remaining(0), pipe(false), bufferedBefore(0) {}
+
+        int fd;  // 文件：dup出来的，发完关闭；payload为-1
+        off_t offset;
+        size_t remaining;
+        bool pipe;  // 管道用splice，其他文件用sendfile
+        PayloadPtr payload;  // 零拷贝发送的数据
+        // 在它之前（上一个区间之后）要先发完的outputBuffer_字节数
+        size_t bufferedBefore;
+    };
+
+    // outputBuffer_和所有区间都发完了
+    bool outputEmpty() const {
+        return outputBuffer_.readableBytes() == 0 && outputRegions_.empty();
+    }
+    // 还没发出去的字节数：outputBuffer_加上所有区间剩下的，高低水位都按它判断
+    size_t outputBytes() const;
+    // 待发送的数据从oldLen涨到newLen，越过高水位时回调
+    void checkHighWaterMark(size_t oldLen, size_t newLen);
+    bool useZeroCopy(size_t len) const {
+        return zeroCopyMinBytes_ > 0 && len >= zeroCopyMinBytes_;
+    }
+    void sendRegionInLoop(OutputRegion& region);
+    // 按顺序发送一次：先发队首区间之前的缓冲数据，再发这个区间
+    ssize_t writeOutput(int* savedErrno);
+    // 发送一次区间，返回写出的字节数；发完（或者文件已经到头）时remaining为0
+    ssize_t writeRegion(OutputRegion* region, int* savedErrno);
+    // 读错误队列里的零拷贝完成通知，释放已经完成的payload，返回是否读到了通知
+    bool handleZeroCopyCompletions();
 
     // 这里绝对不是baseLoop,因为TcpConnection都是在subLoop里面管理的
     EventLoop* loop_;
     const std::string name_;
+    const uint64_t id_;
     std::atomic_int state_;
     bool reading_;
 
@@ -116,11 +221,25 @@ private:
     MessageCallback messageCallback_;        // 有读写消息时的回调
     WriteCompleteCallback writeCompleteCallback_;  // 消息发送完成以后的回调
     HighWaterMarkCallback highWaterMarkCallback_;
+    LowWaterMarkCallback lowWaterMarkCallback_;
     CloseCallback closeCallback_;
     size_t highWaterMark_;  // 指定多少算水位线
+    size_t lowWaterMark_;
+    bool aboveHighWaterMark_;  // 越过了高水位，还没回落到低水位
+    size_t inputHighWaterMark_;  // 0表示不限制
+    size_t readBudgetBytes_;  // 0表示不限制
+    int readBudgetReads_;     // 0表示默认（LT一次，ET不限制）
+    bool readPending_;        // ET模式下已经排了一个continueRead
 
     Buffer inputBuffer_;   // 接收数据的缓冲区
-    Buffer outputBuffer_;  // 发送数据的缓冲区
+    ChainBuffer outputBuffer_;  // 发送数据的缓冲区（分段，writev发送）
+    std::deque<OutputRegion> outputRegions_;  // 等待发送的文件/零拷贝区间
+
+    size_t zeroCopyMinBytes_;
+    uint32_t zeroCopyNextId_;  // 下一次MSG_ZEROCOPY发送的编号，内核按同样的规则从0开始计数
+    // 已经交给内核、还没收到完成通知的payload，和它最后一次发送的编号
+    std::deque<std::pair<uint32_t, PayloadPtr>> zeroCopyInFlight_;
+    Timestamp lastActive_;
     std::any context_;
 };
 
@@ -1,7 +1,9 @@
 #include "TcpServer.h"
+#include "CountDownLatch.h"
 #include "Logger.h"
 #include "TcpConnection.h"
 
+#include <assert.h>
 #include <strings.h>
 #include <functional>
 
@@ -20,29 +22,72 @@ TcpServer::TcpServer(EventLoop* loop,
                      const std::string& nameArg,
                      Option option)
     : loop_(CheckLoopNotNull(loop)),
+      listenAddr_(listenAddr),
       ipPort_(listenAddr.toIpPort()),
       name_(nameArg),
-      acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
+      option_(option),
+      acceptor_(option == kReusePortPerLoop
+                    ? nullptr
+                    : new Acceptor(loop, listenAddr, option == kReusePort)),
       threadPool_(new EventLoopThreadPool(loop, name_)),
       connectionCallback_(),
       messageCallback_(),
-      nextConnId_(1),
+      edgeTriggered_(false),
+      zeroCopyMinBytes_(0),
+      readBudgetBytes_(0),
+      readBudgetReads_(0),
+      inputHighWaterMark_(0),
+      eventTimeBudget_(0),
+      idleSeconds_(0.0),
+      listenBacklog_(1024),
+      maxAcceptsPerEvent_(16),
+      incomingCpuAffinity_(false),
       started_(0) {
     // 当有先用户连接时，会执行TcpServer::newConnection回调
-    acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, 
-                                        std::placeholders::_1, std::placeholders::_2));
+    if (acceptor_) {
+        acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this,
+                                            std::placeholders::_1, std::placeholders::_2));
+    }
 }
 
 TcpServer::~TcpServer() {
-    for (auto& item : connections_) {
+    // 每个分片在自己的loop线程里清理：先摘掉Acceptor，之后就不会再有新连接回调到这个TcpServer，
+    // 再销毁连接。等所有分片都清理完再返回
+    int others = 0;
+    for (const auto& shard : shards_) {
+        if (!shard->loop->isInLoopThread()) {
+            ++others;
+        }
+    }
+    CountDownLatch latch(others);
+    for (const auto& shard : shards_) {
+        ConnectionShard* s = shard.get();
+        if (s->loop->isInLoopThread()) {
+            destroyShard(s);
+        } else {
+            s->loop->runInLoop([this, s, &latch] {
+                destroyShard(s);
+                latch.countDown();
+            });
+        }
+    }
+    latch.wait();
+}
+
+void TcpServer::destroyShard(ConnectionShard* shard) {
+    shard->acceptor.reset();
+    shard->idleReaper.reset();
+    std::unordered_map<uint64_t, TcpConnectionPtr> connections;
+    connections.swap(shard->connections);
+    for (auto& item : connections) {
         // 这个局部的shared_ptr智能指针对象，出右中括号（当前代码块），可以自动释放new出来的TcpConnection对象资源了
         // 下一行reset释放后用不了item.second
         TcpConnectionPtr conn(item.second);
         item.second.reset();
 
-        // 销毁连接
-        conn->getLoop()->runInLoop(
-            std::bind(&TcpConnection::connectDestroyed, conn));
+        // 销毁连接（已经在它的loop线程里了）
+        shard->loop->adjustNumConnections(-1);
+        conn->connectDestroyed();
     }
 }
 
@@ -51,6 +96,26 @@ void TcpServer::setThreadNum(int numThreads) {
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setLoopSelection(EventLoopThreadPool::LoopSelection selection) {
+    threadPool_->setLoopSelection(selection);
+}
+
+void TcpServer::setLoopSelector(const EventLoopThreadPool::LoopSelector& selector) {
+    threadPool_->setLoopSelector(selector);
+}
+
+void TcpServer::setCpuAffinity(const std::vector<int>& cpus) {
+    threadPool_->setCpuAffinity(cpus);
+}
+
+void TcpServer::setPollerType(Poller::Type pollerType) {
+    threadPool_->setPollerType(pollerType);
+}
+
+void TcpServer::setTimerQueueType(TimerQueue::Type timerQueueType) {
+    threadPool_->setTimerQueueType(timerQueueType);
+}
+
 // 开启服务器监听   loop.loop()
 void TcpServer::start() {
     if (started_++ == 0)  // 防止一个TcpServer对象被start多次
@@ -58,18 +123,92 @@ void TcpServer::start() {
         // 把subpool都启动起来
         // threadInitCallback_线程初始化的回调
         threadPool_->start(threadInitCallback_);  // 启动底层的loop线程池
-        // 执行 Acceptor::listen
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        if (eventTimeBudget_ > 0) {
+            for (EventLoop* ioLoop : threadPool_->getAllLoops()) {
+                ioLoop->runInLoop(std::bind(&EventLoop::setEventTimeBudget,
+                                            ioLoop, eventTimeBudget_));
+            }
+        }
+        std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+        for (size_t i = 0; i < loops.size(); ++i) {
+            EventLoop* ioLoop = loops[i];
+            std::unique_ptr<ConnectionShard> shard(new ConnectionShard(ioLoop, i));
+            if (idleSeconds_ > 0.0) {
+                shard->idleReaper.reset(new IdleReaper(ioLoop, idleSeconds_));
+                shard->idleReaper->start();
+            }
+            if (option_ == kReusePortPerLoop) {
+                // 每个loop一个监听socket，端口相同，内核按四元组的哈希把新连接分给它们
+                // accept之后直接在本线程建立连接
+                shard->acceptor.reset(new Acceptor(ioLoop, listenAddr_, true));
+                shard->acceptor->setNewConnectionCallback(
+                    [this, ioLoop](int sockfd, const InetAddress& peerAddr) {
+                        ioLoop->adjustNumConnections(1);
+                        establishConnection(ioLoop, sockfd, peerAddr);
+                    });
+                shard->acceptor->setBacklog(listenBacklog_);
+                shard->acceptor->setMaxAcceptsPerEvent(maxAcceptsPerEvent_);
+                int cpu = threadPool_->cpuOfLoop(ioLoop);
+                if (incomingCpuAffinity_ && cpu >= 0 &&
+                    !shard->acceptor->setIncomingCpu(cpu)) {
+                    LOG_ERROR("TcpServer::start [%s] SO_INCOMING_CPU not supported\n",
+                              name_.c_str());
+                }
+            }
+            shards_.push_back(std::move(shard));
+        }
+        // 分片都建好之后才开始accept
+        if (option_ == kReusePortPerLoop) {
+            for (const auto& shard : shards_) {
+                shard->loop->runInLoop(
+                    std::bind(&Acceptor::listen, shard->acceptor.get()));
+            }
+        } else {
+            acceptor_->setBacklog(listenBacklog_);
+            acceptor_->setMaxAcceptsPerEvent(maxAcceptsPerEvent_);
+            // 执行 Acceptor::listen
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
     }
 }
 
 // 有一个新的客户端的连接，acceptor会执行这个回调操作
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr) {
-    // 轮询算法，选择一个shubloop，来管理channel
-    EventLoop* ioLoop = threadPool_->getNextLoop();
+    // 优先交给收包CPU上的loop，否则按选择策略（默认轮询）选择一个subloop，来管理channel
+    EventLoop* ioLoop = nullptr;
+    if (incomingCpuAffinity_) {
+        ioLoop = threadPool_->getLoopForCpu(Socket::incomingCpu(sockfd));
+    }
+    if (ioLoop == nullptr) {
+        ioLoop = threadPool_->getNextLoop(peerAddr);
+    }
+    // 马上记到ioLoop的连接数上，紧接着的新连接按连接数选择loop时能看到
+    ioLoop->adjustNumConnections(1);
+    // 连接对象在ioLoop线程里创建、登记，mainLoop只负责accept和转交
+    ioLoop->runInLoop(std::bind(&TcpServer::establishConnection, this, ioLoop,
+                                sockfd, peerAddr));
+}
+
+TcpServer::ConnectionShard* TcpServer::shardOf(EventLoop* ioLoop) const {
+    for (const auto& shard : shards_) {
+        if (shard->loop == ioLoop) {
+            return shard.get();
+        }
+    }
+    return nullptr;
+}
+
+void TcpServer::establishConnection(EventLoop* ioLoop,
+                                    int sockfd,
+                                    const InetAddress& peerAddr) {
+    // getNextLoop/getLoopForCpu只会返回线程池里的loop，每个都有分片
+    ConnectionShard* shard = shardOf(ioLoop);
+    assert(shard != nullptr);
+    // 各个分片的id交错分配，不需要共享的计数器：id % 分片数 就是所在的分片
+    uint64_t id = shard->nextSeq++ * shards_.size() + shard->index + 1;
     char buf[64] = {0};
-    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_;
+    snprintf(buf, sizeof buf, "-%s#%lu", ipPort_.c_str(),
+             static_cast<unsigned long>(id));
     std::string connName = name_ + buf;
 
     LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s \n",
@@ -87,33 +226,103 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr) {
     // 根据连接成功的sockfd，创建TcpConnection连接对象
     // sockfd: Socket Channel
     TcpConnectionPtr conn(
-        new TcpConnection(ioLoop, connName, sockfd, localAddr, peerAddr));
-    connections_[connName] = conn;
+        new TcpConnection(ioLoop, connName, sockfd, localAddr, peerAddr, id));
+    shard->connections[id] = conn;
     // 下面的回调都是用户设置给TcpServer=>TcpConnection=>Channel=>Poller=>notify
     // channel调用回调
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    if (zeroCopyMinBytes_ > 0) {
+        conn->setZeroCopy(zeroCopyMinBytes_);
+    }
+    conn->setReadBudget(readBudgetBytes_, readBudgetReads_);
+    conn->setInputHighWaterMark(inputHighWaterMark_);
 
     // 设置了如何关闭连接的回调   conn->shutDown()
     conn->setCloseCallback(
         std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
 
-    // 直接调用TcpConnection::connectEstablished
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    // 已经在ioLoop线程里，直接调用TcpConnection::connectEstablished
+    conn->connectEstablished();
+    if (shard->idleReaper) {
+        shard->idleReaper->add(conn);
+    }
 }
 
-void TcpServer::removeConnection(const TcpConnectionPtr& conn) {
-    loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
+int64_t TcpServer::numIdleReaped() const {
+    int64_t n = 0;
+    for (const auto& shard : shards_) {
+        if (shard->idleReaper) {
+            n += shard->idleReaper->reaped();
+        }
+    }
+    return n;
+}
+
+std::vector<Acceptor*> TcpServer::acceptors() const {
+    std::vector<Acceptor*> result;
+    if (acceptor_) {
+        result.push_back(acceptor_.get());
+    }
+    for (const auto& shard : shards_) {
+        if (shard->acceptor) {
+            result.push_back(shard->acceptor.get());
+        }
+    }
+    return result;
+}
+
+int64_t TcpServer::numAccepted() const {
+    int64_t n = 0;
+    for (Acceptor* acceptor : acceptors()) {
+        n += acceptor->numAccepted();
+    }
+    return n;
+}
+
+int64_t TcpServer::numAcceptDropped() const {
+    int64_t n = 0;
+    for (Acceptor* acceptor : acceptors()) {
+        n += acceptor->numDropped();
+    }
+    return n;
+}
+
+int64_t TcpServer::numAcceptErrors() const {
+    int64_t n = 0;
+    for (Acceptor* acceptor : acceptors()) {
+        n += acceptor->numErrors();
+    }
+    return n;
 }
 
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn) {
-    LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s\n",
+int TcpServer::acceptBacklogLength() const {
+    int n = 0;
+    for (Acceptor* acceptor : acceptors()) {
+        int len = acceptor->backlogLength();
+        if (len < 0) {
+            return -1;
+        }
+        n += len;
+    }
+    return n;
+}
+
+// 在连接所属的loop线程中调用（TcpConnection::handleClose），就地移除，不经过mainLoop
+void TcpServer::removeConnection(const TcpConnectionPtr& conn) {
+    LOG_INFO("TcpServer::removeConnection [%s] - connection %s\n",
              name_.c_str(), conn->name().c_str());
 
-    size_t n = connections_.erase(conn->name());
-    EventLoop* ioLoop = conn->getLoop();
-    ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    ConnectionShard* shard = shards_[(conn->id() - 1) % shards_.size()].get();
+    size_t n = shard->connections.erase(conn->id());
+    // 不在分片里说明TcpServer析构时已经销毁过了
+    if (n == 1) {
+        EventLoop* ioLoop = conn->getLoop();
+        ioLoop->adjustNumConnections(-1);
+        ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    }
 }
 
-}
\ No newline at end of file
+}
@@ -9,6 +9,7 @@
 #include "Callbacks.h"
 #include "EventLoop.h"
 #include "EventLoopThreadPool.h"
+#include "IdleReaper.h"
 #include "InetAddress.h"
 #include "TcpConnection.h"
 #include "noncopyable.h"
@@ -18,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace mynetlib
 {
@@ -31,6 +33,9 @@ public:
     enum Option {
         kNoReusePort,
         kReusePort,
+        // 每个subloop一个SO_REUSEPORT的监听socket，由内核把新连接分给各个loop，
+        // 各自accept、直接在本线程建立连接，不经过mainLoop转交
+        kReusePortPerLoop,
     };
 
     TcpServer(EventLoop* loop,
@@ -54,29 +59,96 @@ public:
 
     // 设置底层subloop的个数
     void setThreadNum(int numThreads);
+    // 新连接分配给subloop的策略（kReusePortPerLoop时由内核分配，不使用），需要在start之前设置
+    void setLoopSelection(EventLoopThreadPool::LoopSelection selection);
+    void setLoopSelector(const EventLoopThreadPool::LoopSelector& selector);
+    // subloop线程绑核，见EventLoopThreadPool::setCpuAffinity，需要在start之前设置
+    void setCpuAffinity(const std::vector<int>& cpus);
+    // 让连接落在收包的CPU上的loop里（需要先setCpuAffinity，网卡队列的中断亲和性也要对应上）：
+    //   kReusePortPerLoop：每个loop的监听socket设置SO_INCOMING_CPU，由内核挑选监听socket
+    //   单个Acceptor：accept之后按连接的SO_INCOMING_CPU找对应的loop，找不到时按选择策略
+    // 需要在start之前设置
+    void setIncomingCpuAffinity(bool on) { incomingCpuAffinity_ = on; }
+    // 设置subloop使用的IO复用实现（mainLoop由用户自己构造时指定）
+    void setPollerType(Poller::Type pollerType);
+    // 设置subloop使用的定时器队列实现，连接很多、每个连接都有超时定时器时用kWheel
+    void setTimerQueueType(TimerQueue::Type timerQueueType);
+    // 新连接是否使用边沿触发（EPOLLET），适合大块数据传输的连接，默认水平触发
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    // 新连接上不小于minBytes的 send(std::string&&) / send(PayloadPtr) 用MSG_ZEROCOPY发送，0表示不用（默认）
+    void setZeroCopy(size_t minBytes) { zeroCopyMinBytes_ = minBytes; }
+    // 新连接的读预算，见TcpConnection::setReadBudget
+    void setReadBudget(size_t maxBytes, int maxReads) {
+        readBudgetBytes_ = maxBytes;
+        readBudgetReads_ = maxReads;
+    }
+    // 新连接的输入高水位，见TcpConnection::setInputHighWaterMark
+    void setInputHighWaterMark(size_t bytes) { inputHighWaterMark_ = bytes; }
+    // subloop每一轮处理IO事件的时间预算（微秒），见EventLoop::setEventTimeBudget，需要在start之前设置
+    void setEventTimeBudget(int64_t microseconds) { eventTimeBudget_ = microseconds; }
+    // 连接空闲（没有收发数据）超过seconds秒就关闭，<=0表示不检查（默认），需要在start之前设置
+    void setIdleTimeout(double seconds) { idleSeconds_ = seconds; }
+
+    // 监听socket全连接队列的长度（默认1024），需要在start之前设置
+    void setListenBacklog(int backlog) { listenBacklog_ = backlog; }
+    // 一次可读事件最多accept多少个连接（默认16），需要在start之前设置
+    void setMaxAcceptsPerEvent(int n) { maxAcceptsPerEvent_ = n; }
+
+    // 因为空闲超时被关闭的连接总数
+    int64_t numIdleReaped() const;
+    // accept统计（所有Acceptor之和，见Acceptor::numAccepted等），start之后任意线程调用
+    int64_t numAccepted() const;
+    int64_t numAcceptDropped() const;
+    int64_t numAcceptErrors() const;
+    // 全连接队列里等待accept的连接数，取不到时返回-1
+    int acceptBacklogLength() const;
 
     // 开启服务器监听
     void start();
 
     EventLoop* getLoop() const { return loop_; }
+    // start之后可以用来查看各个subloop（比如每个loop的连接数）
+    std::shared_ptr<EventLoopThreadPool> threadPool() const { return threadPool_; }
     std::string name() const { return name_; }
     std::string ipPort() const { return ipPort_; }
 
 private:
+    // 每个loop一份的连接表，连接的建立、移除都只在所属loop线程里进行，不需要锁，也不经过mainLoop
+    struct ConnectionShard {
+        ConnectionShard(EventLoop* loopArg, uint64_t indexArg)
+            : loop(loopArg), index(indexArg), nextSeq(0) {}
+
+        EventLoop* loop;
+        const uint64_t index;  // 第几个分片
+        uint64_t nextSeq;      // 本分片下一个连接的序号
+        std::unordered_map<uint64_t, TcpConnectionPtr> connections;  // 以连接id为键
+        std::unique_ptr<Acceptor> acceptor;  // kReusePortPerLoop时这个loop的Acceptor
+        std::shared_ptr<IdleReaper> idleReaper;
+    };
+
+    // mainLoop的Acceptor回调，选好loop后把sockfd转交过去
     void newConnection(int sockfd, const InetAddress& peerAddr);
-    // 在map中移除TcpConnection
+    // 在ioLoop线程中用sockfd建立连接
+    void establishConnection(EventLoop* ioLoop,
+                             int sockfd,
+                             const InetAddress& peerAddr);
+    // 在连接所属的loop线程中从分片里移除TcpConnection
     void removeConnection(const TcpConnectionPtr& conn);
-    void removeConnectionInLoop(const TcpConnectionPtr& conn);
-
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    // 在分片所属的loop线程中销毁它的Acceptor、IdleReaper和所有连接
+    void destroyShard(ConnectionShard* shard);
+    ConnectionShard* shardOf(EventLoop* ioLoop) const;
+    // 当前在用的Acceptor：acceptor_或者每个loop的
+    std::vector<Acceptor*> acceptors() const;
 
     EventLoop* loop_;  // baseLoop 用户定义的loop
 
+    const InetAddress listenAddr_;
     const std::string ipPort_;
     const std::string name_;
+    const Option option_;
 
     std::unique_ptr<Acceptor>
-        acceptor_;  // 运行在mainLoop，任务就是监听新连接事件
+        acceptor_;  // 运行在mainLoop，任务就是监听新连接事件；kReusePortPerLoop时为空
 
     std::shared_ptr<EventLoopThreadPool> threadPool_;  // one loop per thread
 
@@ -86,10 +158,22 @@ private:
 
     ThreadInitCallback threadInitCallback_;  // loop线程初始化的回调
 
+    bool edgeTriggered_;
+    size_t zeroCopyMinBytes_;
+    size_t readBudgetBytes_;
+    int readBudgetReads_;
+    size_t inputHighWaterMark_;
+    int64_t eventTimeBudget_;
+    double idleSeconds_;
+    int listenBacklog_;
+    int maxAcceptsPerEvent_;
+    bool incomingCpuAffinity_;
+
     std::atomic_int started_;
 
-    int nextConnId_;
-    ConnectionMap connections_;  // 保存所有的连接
+    // 每个loop一个分片，start时创建，之后不再增减；连接id对分片数取模就是它所在的分片
+    // 析构时在各自的loop线程里清空（loop还活着）
+    std::vector<std::unique_ptr<ConnectionShard>> shards_;
 };
 
 }
\ No newline at end of file
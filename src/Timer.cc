@@ -1,4 +1,3 @@
-
 #include "Timer.h"
 
 namespace mynetlib
@@ -6,6 +5,25 @@ namespace mynetlib
 
 std::atomic_int64_t Timer::s_numCreated_;
 
+void Timer::init(TimerCallback&& cb, Timestamp when, double interval)
+{
+    callback_ = std::move(cb);
+    expiration_ = when;
+    interval_ = interval;
+    repeat_ = interval > 0.0;
+    canceled_ = false;
+    sequece_.store(++s_numCreated_, std::memory_order_relaxed);
+}
+
+void Timer::clear()
+{
+    // 尽早释放回调里持有的资源
+    callback_ = nullptr;
+    sequece_.store(0, std::memory_order_relaxed);
+    heapIndex_ = kNotInHeap;
+    wheelPprev_ = nullptr;
+}
+
 void Timer::restart(Timestamp now)
 {
     if(repeat_)
@@ -18,4 +36,43 @@ void Timer::restart(Timestamp now)
     }
 }
 
-}
\ No newline at end of file
+TimerPool::TimerPool()
+    : freeList_(nullptr),
+      inUse_(0)
+{
+}
+
+Timer* TimerPool::acquire(TimerCallback&& cb, Timestamp when, double interval)
+{
+    Timer* timer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (freeList_ == nullptr)
+        {
+            std::unique_ptr<Timer[]> chunk(new Timer[kChunkSize]);
+            for (size_t i = 0; i < kChunkSize; ++i)
+            {
+                chunk[i].wheelNext_ = freeList_;
+                freeList_ = &chunk[i];
+            }
+            chunks_.push_back(std::move(chunk));
+        }
+        timer = freeList_;
+        freeList_ = timer->wheelNext_;
+        ++inUse_;
+    }
+    timer->wheelNext_ = nullptr;
+    timer->init(std::move(cb), when, interval);
+    return timer;
+}
+
+void TimerPool::release(Timer* timer)
+{
+    timer->clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    timer->wheelNext_ = freeList_;
+    freeList_ = timer;
+    --inUse_;
+}
+
+}
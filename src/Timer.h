@@ -1,6 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "noncopyable.h"
 #include "Callbacks.h"
@@ -8,17 +11,20 @@
 
 namespace mynetlib
 {
- 
+
+// 定时器对象由所属TimerQueue的TimerPool分配和回收，内存在TimerQueue析构前不会释放
+// 所以TimerId里的裸指针总是可以解引用，用sequence判断它是不是还是原来那个定时器
 class Timer : noncopyable
 {
 public:
-    // 构造函数
-    Timer(TimerCallback cb, Timestamp when, double interval)
-        : callback_(std::move(cb)),
-          expiration_(when),
-          interval_(interval),
-          repeat_(interval > 0.0),
-          sequece_(++s_numCreated_) // 一次性定时器设置为0
+    Timer()
+        : interval_(0.0),
+          repeat_(false),
+          canceled_(false),
+          sequece_(0),
+          heapIndex_(kNotInHeap),
+          wheelNext_(nullptr),
+          wheelPprev_(nullptr)
     {}
 
     // 调用此定时器的回调函数
@@ -30,7 +36,8 @@ public:
     // 返回此定时器超时时间
     Timestamp expiration() const { return expiration_; }
     bool repeat() const { return repeat_; }
-    int64_t sequece() const { return sequece_; }
+    // 0表示这个Timer当前是空闲的
+    int64_t sequece() const { return sequece_.load(std::memory_order_relaxed); }
 
     // 重启定时器(如果是非重复事件则到期时间置为0)
     void restart(Timestamp now);
@@ -38,17 +45,60 @@ public:
     static int64_t numCreated() { return s_numCreated_; }
 
 private:
-    
-    const TimerCallback callback_;
+    friend class TimerPool;
+    friend class SortedTimerQueue;
+    friend class TimerWheel;
+
+    static const size_t kNotInHeap = static_cast<size_t>(-1);
+
+    // 由TimerPool在分配/回收时调用
+    void init(TimerCallback&& cb, Timestamp when, double interval);
+    void clear();
+
+    TimerCallback callback_;
     Timestamp expiration_;
-    const double interval_;
-    const bool repeat_;
-    const int64_t sequece_;
+    double interval_;
+    bool repeat_;
+    // 在到期回调执行期间被取消，回调结束后不再重启
+    bool canceled_;
+    // 取消时loop线程可能读到正在被其他线程重新分配的Timer，所以用原子变量
+    std::atomic<int64_t> sequece_;
+
+    // SortedTimerQueue用的，在堆中的下标，删除时O(log n)
+    size_t heapIndex_;
+
+    // TimerWheel用的侵入式链表，挂在时间轮的某一格上，取消时O(1)摘下
+    // wheelPprev_指向前一个结点的wheelNext_（或者格子的头指针）
+    // 空闲的Timer也用wheelNext_串成TimerPool的空闲链表
+    Timer* wheelNext_;
+    Timer** wheelPprev_;
 
     static std::atomic_int64_t s_numCreated_;
 };
 
+// 每个TimerQueue一个的Timer分配器
+// 一次分配kChunkSize个Timer，释放的Timer放回空闲链表复用，在loop线程里添加/取消定时器不再new/delete
+// （其他线程调用时，投递到loop的回调本身仍要分配std::function和MPSC队列节点）
+// addTimer可以在其他线程调用，所以用一把锁保护空闲链表（几乎不会有竞争）
+class TimerPool : noncopyable
+{
+public:
+    TimerPool();
+
+    Timer* acquire(TimerCallback&& cb, Timestamp when, double interval);
+    void release(Timer* timer);
 
+    // 已经分配出去的Timer个数 / 总共持有的Timer个数
+    size_t inUse() const { return inUse_; }
+    size_t capacity() const { return chunks_.size() * kChunkSize; }
 
-}
+private:
+    static const size_t kChunkSize = 256;
 
+    std::mutex mutex_;
+    Timer* freeList_;
+    size_t inUse_;
+    std::vector<std::unique_ptr<Timer[]>> chunks_;
+};
+
+}
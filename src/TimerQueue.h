@@ -1,70 +1,72 @@
 #pragma once
 
 #include <memory>
-#include <set>
 #include <utility>
 #include <vector>
 
 #include "noncopyable.h"
 #include "Callbacks.h"
 #include "Channel.h"
+#include "Timer.h"
 #include "Timestamp.h"
 
 namespace mynetlib
 {
 
-class Timer;
 class TimerId;
 
+// 定时器队列的抽象基类，和Poller一样在构造EventLoop时选择具体实现
+// 基类负责timerfd和跨线程的add/cancel，派生类只管怎么组织定时器
 class TimerQueue : public noncopyable
 {
 
 public:
+    // 定时器队列的具体实现
+    enum Type {
+        kDefault,  // 由环境变量决定（MUDUO_USE_TIMER_WHEEL），默认kSorted
+        kSorted,   // 按到期时间排序，微秒精度，add/cancel O(log n)
+        kWheel,    // 分层时间轮，1ms精度，add/cancel O(1)，适合大量的超时定时器
+    };
 
-
-    explicit TimerQueue(EventLoop* loop);
-    ~TimerQueue();
+    virtual ~TimerQueue();
 
     // TimerQueue提供给loop的添加关闭定时器的接口函数。 必须是线程安全的（往往都在其他线程中被调用）
     // 插入定时器（回调函数，到期时间，是否重复）
     TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
     void cancel(TimerId timerId);
 
-private:
-    using TimerPtr = Timer*;
-    using Entry = std::pair<Timestamp, TimerPtr>;
-    using TimerList = std::set<Entry>;
-    using ActiveTimer = std::pair<TimerPtr, int64_t>;
-    using ActiveTimerSet = std::set<ActiveTimer>;
+    // 当前还没到期（或者没被取消）的定时器个数，只在loop线程中调用
+    virtual size_t size() const = 0;
+
+    // 实现在DefaultTimerQueue.cc中，基类不依赖派生类
+    static TimerQueue* newDefaultTimerQueue(EventLoop* loop);
+    static TimerQueue* newTimerQueue(EventLoop* loop, Type type);
 
+protected:
+    explicit TimerQueue(EventLoop* loop);
+
+    // 以下都在loop线程中调用
     // 在本loop中添加定时器
-    // 保证线程安全的操作
-    void addTimerInLoop(TimerPtr timer);
-    void cancelInLoop(TimerId timerId);
+    virtual void addTimerInLoop(Timer* timer) = 0;
+    // timer可能已经到期释放了，要先用sequence确认它还活着
+    virtual void cancelInLoop(Timer* timer, int64_t sequence) = 0;
+    // timerfd可读时调用，处理所有已到期的定时器，并重新设置timerfd
+    virtual void handleExpired(Timestamp now) = 0;
 
+    // 让timerfd在expiration时刻触发
+    void resetTimerfd(Timestamp expiration);
+
+    EventLoop* loop_; // 所属的EventLoop
+    // 派生类到期/取消定时器后用pool_.release回收
+    TimerPool pool_;
+
+private:
     // 定时器读事件触发的函数
     //当timerfd事件就绪时执行
     void handleRead();
 
-    // 移除所有已到期的定时器
-    // 1.获取到期的定时器
-    // 2.重置这些定时器（销毁或者重复定时任务）
-    std::vector<Entry> getExpired(Timestamp now);
-    void reset(const std::vector<Entry>& expired, Timestamp now);
-
-    // 插入定时器的内部方法
-    bool insert(TimerPtr timer);
-
-    EventLoop* loop_; // 所属的EventLoop
     const int timerfd_; // timerfd是Linux提供的定时器接口
     Channel timerfdChannel_;  // 封装timerfd_文件描述符
-    // 存储了Timer， 使用set容器（红黑树），按照Expiration时间进行排序
-    TimerList timers_;
-
-    ActiveTimerSet activeTimers_;
-    bool callingExpiredTimers_; // 正在获取超时定时器标志
-    ActiveTimerSet cancelingTimers_;
-
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,237 @@
+#include "TimerWheel.h"
+#include "Timer.h"
+
+#include <string.h>
+
+namespace mynetlib
+{
+
+TimerWheel::TimerWheel(EventLoop* loop)
+    : TimerQueue(loop),
+      currentTick_(tickOf(Timestamp::now())),
+      armedTick_(INT64_MAX),
+      count_(0),
+      runningTimer_(nullptr)
+{
+    memset(level0_, 0, sizeof level0_);
+    memset(levels_, 0, sizeof levels_);
+}
+
+// 定时器的内存由pool_统一释放
+TimerWheel::~TimerWheel() = default;
+
+// 到期时间向上取整到ms
+int64_t TimerWheel::tickOf(Timestamp when)
+{
+    return (when.microSecondsSinceEpoch() + 999) / 1000;
+}
+
+void TimerWheel::link(Timer* timer)
+{
+    int64_t expires = tickOf(timer->expiration());
+    int64_t delta = expires - currentTick_;
+    Timer** slot;
+    if (delta < kLevel0Size)
+    {
+        // 已经过期的定时器放到当前格，下一次处理时马上执行
+        if (delta < 0)
+        {
+            expires = currentTick_;
+        }
+        slot = &level0_[expires & kLevel0Mask];
+    }
+    else
+    {
+        if (delta > kMaxTicks)
+        {
+            // 超出时间轮的范围，先挂在最远处，转到时再重新分配
+            delta = kMaxTicks;
+            expires = currentTick_ + kMaxTicks;
+        }
+        int level = 0;
+        while (delta >= (1LL << (kLevel0Bits + (level + 1) * kLevelBits)))
+        {
+            ++level;
+        }
+        int shift = kLevel0Bits + level * kLevelBits;
+        slot = &levels_[level][(expires >> shift) & kLevelMask];
+    }
+
+    timer->wheelNext_ = *slot;
+    if (*slot)
+    {
+        (*slot)->wheelPprev_ = &timer->wheelNext_;
+    }
+    *slot = timer;
+    timer->wheelPprev_ = slot;
+}
+
+void TimerWheel::unlink(Timer* timer)
+{
+    *timer->wheelPprev_ = timer->wheelNext_;
+    if (timer->wheelNext_)
+    {
+        timer->wheelNext_->wheelPprev_ = timer->wheelPprev_;
+    }
+    timer->wheelNext_ = nullptr;
+    timer->wheelPprev_ = nullptr;
+}
+
+void TimerWheel::cascade(int level, int index)
+{
+    Timer* list = levels_[level][index];
+    levels_[level][index] = nullptr;
+    while (list)
+    {
+        Timer* timer = list;
+        list = timer->wheelNext_;
+        link(timer);
+    }
+}
+
+void TimerWheel::addTimerInLoop(Timer* timer)
+{
+    if (count_ == 0)
+    {
+        // 时间轮是空的，currentTick_可能停在很久以前，直接拨到现在，省得追赶
+        int64_t nowTick = Timestamp::now().microSecondsSinceEpoch() / 1000;
+        if (currentTick_ < nowTick)
+        {
+            currentTick_ = nowTick;
+        }
+    }
+    link(timer);
+    ++count_;
+
+    // 比timerfd当前设置的时刻还早，需要重新设置
+    if (!runningTimer_ && tickOf(timer->expiration()) < armedTick_)
+    {
+        arm();
+    }
+}
+
+void TimerWheel::cancelInLoop(Timer* timer, int64_t sequence)
+{
+    if (timer == nullptr || timer->sequece() != sequence)
+    {
+        // 已经到期回收，或者已经取消过了（Timer可能被复用成了别的定时器）
+        return;
+    }
+    if (timer == runningTimer_)
+    {
+        // 在自己的回调里取消自己（重复定时器），回调结束后再回收
+        timer->canceled_ = true;
+        return;
+    }
+    if (timer->wheelPprev_ == nullptr)
+    {
+        // 其他线程添加的定时器，还没有挂到时间轮上
+        return;
+    }
+    unlink(timer);
+    --count_;
+    pool_.release(timer);
+}
+
+void TimerWheel::handleExpired(Timestamp now)
+{
+    int64_t nowTick = now.microSecondsSinceEpoch() / 1000;
+    while (currentTick_ <= nowTick && count_ > 0)
+    {
+        int index = static_cast<int>(currentTick_ & kLevel0Mask);
+        if (index == 0)
+        {
+            // 第0层转完一圈，从上一层取下一格分配下来，上一层也转完一圈就继续往上
+            for (int level = 0; level < kUpperLevels; ++level)
+            {
+                int shift = kLevel0Bits + level * kLevelBits;
+                int i = static_cast<int>((currentTick_ >> shift) & kLevelMask);
+                cascade(level, i);
+                if (i != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        // 先把这一格整个摘下来，回调里新加的定时器会挂到后面的格子，不会在这里被处理
+        Timer* expired = level0_[index];
+        level0_[index] = nullptr;
+        if (expired)
+        {
+            expired->wheelPprev_ = &expired;
+        }
+        ++currentTick_;
+
+        while (expired)
+        {
+            // 回调里可能取消了同一格里的其他定时器，所以每次都从头摘
+            Timer* timer = expired;
+            unlink(timer);
+            runTimer(timer, now);
+        }
+    }
+    if (currentTick_ <= nowTick)
+    {
+        // 时间轮空了，直接跳到现在
+        currentTick_ = nowTick + 1;
+    }
+
+    // timerfd已经触发过了，重新设置
+    armedTick_ = INT64_MAX;
+    arm();
+}
+
+void TimerWheel::runTimer(Timer* timer, Timestamp now)
+{
+    runningTimer_ = timer;
+    timer->run();
+    runningTimer_ = nullptr;
+
+    // 重复任务则继续执行
+    if (timer->repeat() && !timer->canceled_)
+    {
+        timer->restart(now);
+        link(timer);
+    }
+    else
+    {
+        --count_;
+        pool_.release(timer);
+    }
+}
+
+// 第0层从当前格往后第一个非空的格子；都是空的就等到下一次cascade
+int64_t TimerWheel::nextWakeTick() const
+{
+    if ((currentTick_ & kLevel0Mask) == 0)
+    {
+        // 还没有cascade
+        return currentTick_;
+    }
+    int64_t boundary = (currentTick_ | kLevel0Mask) + 1;
+    for (int64_t tick = currentTick_; tick < boundary; ++tick)
+    {
+        if (level0_[tick & kLevel0Mask])
+        {
+            return tick;
+        }
+    }
+    return boundary;
+}
+
+void TimerWheel::arm()
+{
+    if (count_ == 0)
+    {
+        return;
+    }
+    int64_t tick = nextWakeTick();
+    if (tick != armedTick_)
+    {
+        armedTick_ = tick;
+        resetTimerfd(Timestamp(tick * 1000));
+    }
+}
+
+}
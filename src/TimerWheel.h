@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "TimerQueue.h"
+
+namespace mynetlib
+{
+
+/**
+ * 分层时间轮（和Linux内核早期的timer wheel一样）
+ *
+ * 一个tick是1ms，共5层:
+ *   第0层 256格，每格1个tick，覆盖256ms
+ *   第1~4层 各64格，每格是下一层一整圈，最远覆盖 2^32 ms（约49天），再远的按49天算
+ * 定时器按剩余时间挂在对应层的格子里（侵入式双向链表），add/cancel都是O(1)；
+ * 第0层转完一圈时，把上一层当前格里的定时器重新分配到下面的层（cascade）
+ *
+ * 到期时间向上取整到ms，不会提前触发，最多晚1ms
+ * timerfd只设置到第0层下一个非空的格子，或者下一次cascade的时刻，不会每个tick都唤醒
+ */
+class TimerWheel : public TimerQueue
+{
+public:
+    explicit TimerWheel(EventLoop* loop);
+    ~TimerWheel() override;
+
+    size_t size() const override { return count_; }
+
+private:
+    static const int kLevel0Bits = 8;
+    static const int kLevelBits = 6;
+    static const int kLevel0Size = 1 << kLevel0Bits;
+    static const int kLevelSize = 1 << kLevelBits;
+    static const int kLevel0Mask = kLevel0Size - 1;
+    static const int kLevelMask = kLevelSize - 1;
+    static const int kUpperLevels = 4;
+    static const int64_t kMaxTicks = (1LL << (kLevel0Bits + kUpperLevels * kLevelBits)) - 1;
+
+    void addTimerInLoop(Timer* timer) override;
+    void cancelInLoop(Timer* timer, int64_t sequence) override;
+    void handleExpired(Timestamp now) override;
+
+    // 按到期时间把timer挂到对应的格子里
+    void link(Timer* timer);
+    void unlink(Timer* timer);
+    // 把第level层（1~4层对应0~3）第index格的定时器重新分配
+    void cascade(int level, int index);
+    void runTimer(Timer* timer, Timestamp now);
+    // 重新设置timerfd
+    void arm();
+    int64_t nextWakeTick() const;
+
+    static int64_t tickOf(Timestamp when);
+
+    // 下一个要处理的tick（第0层的当前格）
+    int64_t currentTick_;
+    // timerfd当前设置的tick，没有设置时是INT64_MAX
+    int64_t armedTick_;
+
+    Timer* level0_[kLevel0Size];
+    Timer* levels_[kUpperLevels][kLevelSize];
+
+    // 时间轮上的定时器个数（包括正在执行回调的）
+    size_t count_;
+    // 正在执行回调的定时器
+    Timer* runningTimer_;
+};
+
+}
@@ -8,17 +8,31 @@ Timestamp::Timestamp() : microSecondsSinceEpoch_(0) {}
 Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
     : microSecondsSinceEpoch_(microSecondsSinceEpoch) {}
 Timestamp Timestamp::now() {
-    time_t ti = time(NULL);
     // 获取当前时间
-    return Timestamp(ti);
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond +
+                     ts.tv_nsec / 1000);
 }
+
+Timestamp Timestamp::nowCoarse() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond +
+                     ts.tv_nsec / 1000);
+}
+
 std::string Timestamp::toString() const {
     char buf[128] = {0};
-    tm* tm_time = localtime(&microSecondsSinceEpoch_);
+    time_t seconds =
+        static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);
+    struct tm tm_time;
+    // localtime不可重入，用线程安全的localtime_r
+    ::localtime_r(&seconds, &tm_time);
     snprintf(buf, 128, "%4d/%02d/%02d %02d:%02d:%02d",
              // tm结构体里的原因，所以要年+1900，月+1
-             tm_time->tm_year + 1900, tm_time->tm_mon + 1, tm_time->tm_mday,
-             tm_time->tm_hour, tm_time->tm_min, tm_time->tm_sec);
+             tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+             tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
     // C形式的字符串
     return buf;
 }
@@ -12,7 +12,12 @@ public:
     Timestamp();
     // 必须建立对象，显式；不允许隐式转换
     explicit Timestamp(int64_t microSecondsSinceEpoch);
+    // 微秒精度的当前时间（clock_gettime(CLOCK_REALTIME)，走vDSO，不陷入内核）
     static Timestamp now();
+    // 粗粒度的当前时间（CLOCK_REALTIME_COARSE，精度是一个tick，通常1~4ms），
+    // 比now()更便宜，适合不在乎毫秒级误差的地方（比如统计、空闲连接检查）
+    static Timestamp nowCoarse();
+    // 本地时间 "2024/01/01 12:00:00"（秒级）
     std::string toString() const;
     std::string toFormattedString(bool showMicroseconds = true) const;
 